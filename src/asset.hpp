@@ -0,0 +1,564 @@
+// 静态资源模块，启动时把wwwroot整个读进内存，通过inotify监视文件变化，变化的文件重新读取后整体替换
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+#ifdef ASSET_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include "log.hpp"
+#include "util.hpp"
+
+#define ASSET_POLL_MS 500 // 监视线程检查退出标志的间隔
+#define ASSET_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE)
+#define ASSET_MIN_COMPRESS 256 // 小于这个字节数的文件不压缩
+
+// 客户端接受的压缩格式，由Accept-Encoding得到
+#define ASSET_GZIP 1
+#define ASSET_BR 2
+
+// 默认的Cache-Control策略，按路径前缀匹配，最长的前缀优先
+// html页面每次都向服务器确认(带ETag，没有变化时返回304)，图片和脚本在浏览器中缓存一段时间
+static const char *ASSET_CACHE_POLICY[][2] = {
+    {"/", "no-cache"},
+    {"/css/", "public, max-age=3600"},
+    {"/js/", "public, max-age=3600"},
+    {"/image/", "public, max-age=86400"},
+};
+
+// 一次响应实际发送的内容
+struct asset_variant
+{
+    const std::string *body; // 响应正文
+    const char *encoding;    // Content-Encoding，不压缩时为nullptr
+    const std::string *etag; // 带引号的ETag，不同压缩格式的ETag不同
+};
+
+// 内存中的一个静态文件，内容不可修改，多个请求共享同一份
+// 可压缩的文件在加载时就压缩好，请求时只按Accept-Encoding挑选，不在请求路径上压缩
+struct asset
+{
+    std::shared_ptr<const std::string> body; // 文件内容
+    std::shared_ptr<const std::string> gzip; // gzip压缩后的内容，不可压缩或者压缩后没有变小时为空
+    std::shared_ptr<const std::string> br;   // brotli压缩后的内容，编译时没有开启ASSET_BROTLI时总为空
+    const char *mime;                        // Content-Type
+    time_t mtime;                            // 文件修改时间
+    std::string etag;                        // 原始内容的ETag，"内容哈希"
+    std::string etag_gzip;                   // gzip变体的ETag，"内容哈希-gz"
+    std::string etag_br;                     // brotli变体的ETag，"内容哈希-br"
+    std::string last_modified;               // Last-Modified，HTTP日期格式
+
+    // 按客户端接受的压缩格式挑选内容
+    asset_variant select(const int accepted) const
+    {
+        if ((accepted & ASSET_BR) && br.get() != nullptr)
+        {
+            return asset_variant{br.get(), "br", &etag_br};
+        }
+        if ((accepted & ASSET_GZIP) && gzip.get() != nullptr)
+        {
+            return asset_variant{gzip.get(), "gzip", &etag_gzip};
+        }
+        return asset_variant{body.get(), nullptr, &etag};
+    }
+
+    // 根据If-None-Match和If-Modified-Since判断客户端的缓存是否还有效，有效时应返回304
+    // 有If-None-Match时只看它；各个压缩变体内容相同，匹配任何一个都算有效
+    bool not_modified(const std::string &if_none_match, const std::string &if_modified_since) const
+    {
+        if (if_none_match.empty() == false)
+        {
+            str_view rest = if_none_match, token;
+            while (string_util::next_token(rest, ',', token))
+            {
+                token = token.trim();
+                if (token == "*")
+                {
+                    return true;
+                }
+                if (token.size > 2 && token[0] == 'W' && token[1] == '/') // 弱比较，忽略W/前缀
+                {
+                    token = token.substr(2);
+                }
+                if (token == etag || token == etag_gzip || token == etag_br)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (if_modified_since.empty() == false && mtime > 0)
+        {
+            struct tm tm;
+            memset(&tm, 0, sizeof(tm));
+            if (strptime(if_modified_since.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm) == nullptr)
+            {
+                return false;
+            }
+            return mtime <= timegm(&tm);
+        }
+        return false;
+    }
+};
+
+typedef std::shared_ptr<const asset> asset_ptr;
+
+// 静态资源缓存：路径到文件的表是不可修改的快照，请求线程只读当前快照，不加锁
+// 文件变化时监视线程复制一份新表，替换变化的文件后原子地换上去，正在使用旧快照的请求不受影响
+class asset_cache
+{
+private:
+    typedef std::unordered_map<std::string, asset_ptr> asset_table; // 键为以'/'开头的相对路径
+
+    std::string _root;                        // 资源根目录，以'/'结尾
+    std::shared_ptr<const asset_table> _table; // 当前快照，只能用std::atomic_load/atomic_store访问
+    asset_ptr _not_found;                     // 404页面
+    int _inotify_fd;
+    std::unordered_map<int, std::string> _watches; // 监视描述符到目录相对路径，只在监视线程中使用
+    std::atomic<bool> _running;
+    std::thread _watcher;
+    std::atomic<uint64_t> _reloads; // 重新读取文件的次数
+    std::vector<std::pair<std::string, std::string>> _policies; // 路径前缀和对应的Cache-Control
+
+    // 按扩展名确定Content-Type
+    static const char *mime_of(const std::string &path)
+    {
+        static const char *MIME[][2] = {
+            {".html", "text/html; charset=utf-8"}, {".css", "text/css; charset=utf-8"},
+            {".js", "application/javascript; charset=utf-8"}, {".json", "application/json"},
+            {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"}, {".png", "image/png"}, {".gif", "image/gif"},
+            {".svg", "image/svg+xml"}, {".ico", "image/x-icon"}, {".txt", "text/plain; charset=utf-8"},
+            {".woff", "font/woff"}, {".woff2", "font/woff2"},
+        };
+        size_t dot = path.rfind('.');
+        if (dot != std::string::npos)
+        {
+            for (auto &m : MIME)
+            {
+                if (path.compare(dot, std::string::npos, m[0]) == 0)
+                {
+                    return m[1];
+                }
+            }
+        }
+        return "application/octet-stream";
+    }
+
+    // 文本类的文件才值得压缩，图片本身已经压缩过
+    static bool compressible(const char *mime)
+    {
+        return strncmp(mime, "text/", 5) == 0 || strstr(mime, "javascript") != nullptr ||
+               strstr(mime, "json") != nullptr || strstr(mime, "svg") != nullptr;
+    }
+
+    // gzip压缩，失败或者没有变小时返回空
+    static std::shared_ptr<const std::string> gzip_compress(const std::string &src)
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) // 15+16为gzip格式
+        {
+            return std::shared_ptr<const std::string>();
+        }
+        std::shared_ptr<std::string> dst(new std::string(deflateBound(&zs, src.size()), '\0'));
+        zs.next_in = (Bytef *)src.data();
+        zs.avail_in = src.size();
+        zs.next_out = (Bytef *)&(*dst)[0];
+        zs.avail_out = dst->size();
+        int ret = deflate(&zs, Z_FINISH);
+        dst->resize(zs.total_out);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END || dst->size() >= src.size())
+        {
+            return std::shared_ptr<const std::string>();
+        }
+        return dst;
+    }
+
+    // brotli压缩，失败或者没有变小时返回空
+    static std::shared_ptr<const std::string> brotli_compress(const std::string &src)
+    {
+#ifdef ASSET_BROTLI
+        size_t size = BrotliEncoderMaxCompressedSize(src.size());
+        std::shared_ptr<std::string> dst(new std::string(size, '\0'));
+        if (size == 0 || BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, src.size(),
+                                               (const uint8_t *)src.data(), &size, (uint8_t *)&(*dst)[0]) == BROTLI_FALSE ||
+            size >= src.size())
+        {
+            return std::shared_ptr<const std::string>();
+        }
+        dst->resize(size);
+        return dst;
+#else
+        (void)src;
+        return std::shared_ptr<const std::string>();
+#endif
+    }
+
+    // 64位FNV-1a哈希，用作ETag
+    static uint64_t content_hash(const std::string &data)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : data)
+        {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // 由文件内容生成资源：压缩出各个变体，计算ETag和Last-Modified，之后每次请求直接使用
+    static std::shared_ptr<asset> make_asset(const std::shared_ptr<std::string> &body, const char *mime, const time_t mtime)
+    {
+        std::shared_ptr<asset> ap(new asset{body, nullptr, nullptr, mime, mtime, "", "", "", ""});
+        if (body->size() >= ASSET_MIN_COMPRESS && compressible(mime))
+        {
+            ap->gzip = gzip_compress(*body);
+            ap->br = brotli_compress(*body);
+        }
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)content_hash(*body));
+        ap->etag = std::string("\"") + buf + "\"";
+        ap->etag_gzip = std::string("\"") + buf + "-gz\"";
+        ap->etag_br = std::string("\"") + buf + "-br\"";
+        struct tm tm;
+        gmtime_r(&mtime, &tm);
+        strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        ap->last_modified = buf;
+        return ap;
+    }
+
+    // 读取一个文件并生成资源，失败返回空
+    asset_ptr load_file(const std::string &rel)
+    {
+        std::string full = _root + rel.substr(1);
+        struct stat st;
+        if (stat(full.c_str(), &st) != 0 || S_ISREG(st.st_mode) == false)
+        {
+            return asset_ptr();
+        }
+        std::shared_ptr<std::string> body(new std::string());
+        if (read_util::read(full, *body) == false)
+        {
+            return asset_ptr();
+        }
+        return make_asset(body, mime_of(rel), st.st_mtime);
+    }
+
+    // 递归读取目录rel下的所有文件放进table，监视线程启动后同时监视各级目录
+    void load_dir(const std::string &rel, asset_table &table)
+    {
+        std::string full = _root + rel.substr(1);
+        DIR *dir = opendir(full.c_str());
+        if (dir == nullptr)
+        {
+            ELOG("%s open dir failed", full.c_str());
+            return;
+        }
+        add_watch(rel);
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            if (entry->d_name[0] == '.') // 跳过 . .. 和隐藏文件
+            {
+                continue;
+            }
+            std::string child = rel + entry->d_name;
+            struct stat st;
+            if (stat((_root + child.substr(1)).c_str(), &st) != 0)
+            {
+                continue;
+            }
+            if (S_ISDIR(st.st_mode))
+            {
+                load_dir(child + "/", table);
+            }
+            else if (S_ISREG(st.st_mode))
+            {
+                asset_ptr ap = load_file(child);
+                if (ap.get() != nullptr)
+                {
+                    table[child] = ap;
+                }
+            }
+        }
+        closedir(dir);
+    }
+
+    void add_watch(const std::string &rel)
+    {
+        if (_inotify_fd < 0)
+        {
+            return;
+        }
+        int wd = inotify_add_watch(_inotify_fd, (_root + rel.substr(1)).c_str(), ASSET_WATCH_MASK);
+        if (wd < 0)
+        {
+            ELOG("inotify watch %s failed", rel.c_str());
+            return;
+        }
+        _watches[wd] = rel;
+    }
+
+    // 从table中移除目录rel下的所有文件，并取消对各级目录的监视
+    // 删除的目录内核已经自动取消监视，inotify_rm_watch失败也没有关系；移走的目录还在，必须取消
+    void remove_dir(const std::string &rel, asset_table &table)
+    {
+        for (auto it = table.begin(); it != table.end();)
+        {
+            if (it->first.compare(0, rel.size(), rel) == 0)
+            {
+                it = table.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for (auto it = _watches.begin(); it != _watches.end();)
+        {
+            if (it->second.compare(0, rel.size(), rel) == 0)
+            {
+                inotify_rm_watch(_inotify_fd, it->first);
+                it = _watches.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        DLOG("静态资源目录 %s 已移除", rel.c_str());
+    }
+
+    // 设置404页面，404.html不存在或为空时用内置的页面
+    void update_not_found(const asset_table &table)
+    {
+        auto it = table.find("/404.html");
+        asset_ptr ap;
+        if (it != table.end() && it->second->body->empty() == false)
+        {
+            ap = it->second;
+        }
+        else
+        {
+            std::shared_ptr<std::string> body(new std::string("<html><body><h1>404 Not Found</h1></body></html>"));
+            ap = make_asset(body, "text/html; charset=utf-8", 0);
+        }
+        std::atomic_store(&_not_found, ap);
+    }
+
+    // 监视线程：处理inotify事件，把一批事件涉及的文件重新读取后一次性换上新快照
+    void watch_loop()
+    {
+        char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        while (_running)
+        {
+            struct pollfd pfd = {_inotify_fd, POLLIN, 0};
+            if (poll(&pfd, 1, ASSET_POLL_MS) <= 0)
+            {
+                continue;
+            }
+            ssize_t len = read(_inotify_fd, buf, sizeof(buf));
+            if (len <= 0)
+            {
+                continue;
+            }
+            std::shared_ptr<asset_table> table(new asset_table(*std::atomic_load(&_table)));
+            for (char *p = buf; p < buf + len;)
+            {
+                struct inotify_event *event = (struct inotify_event *)p;
+                p += sizeof(struct inotify_event) + event->len;
+                auto wit = _watches.find(event->wd);
+                if (wit == _watches.end() || event->len == 0 || event->name[0] == '.')
+                {
+                    continue;
+                }
+                std::string rel = wit->second + event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) // 新目录，监视并读取其中的文件
+                    {
+                        load_dir(rel + "/", *table);
+                    }
+                    else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) // 目录被删除或移走，其中的文件都不再提供
+                    {
+                        remove_dir(rel + "/", *table);
+                    }
+                    continue;
+                }
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    table->erase(rel);
+                    continue;
+                }
+                // IN_CREATE之后文件可能还没有写完，等IN_CLOSE_WRITE再读取
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    asset_ptr ap = load_file(rel);
+                    if (ap.get() != nullptr)
+                    {
+                        (*table)[rel] = ap;
+                        _reloads++;
+                        DLOG("静态资源 %s 已重新加载", rel.c_str());
+                    }
+                }
+            }
+            update_not_found(*table);
+            std::atomic_store(&_table, std::shared_ptr<const asset_table>(table));
+        }
+    }
+
+public:
+    asset_cache(const std::string &root)
+        : _root(root), _inotify_fd(-1), _running(false), _reloads(0)
+    {
+        if (_root.empty() || _root.back() != '/')
+        {
+            _root += '/';
+        }
+        for (auto &policy : ASSET_CACHE_POLICY)
+        {
+            set_cache_control(policy[0], policy[1]);
+        }
+        _inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_inotify_fd < 0)
+        {
+            ELOG("inotify init failed, 静态资源不会自动重新加载");
+        }
+        std::shared_ptr<asset_table> table(new asset_table());
+        load_dir("/", *table);
+        update_not_found(*table);
+        _table = table;
+        DLOG("静态资源加载完毕，共%lu个文件", (unsigned long)table->size());
+        if (_inotify_fd >= 0)
+        {
+            _running = true;
+            _watcher = std::thread(&asset_cache::watch_loop, this);
+        }
+    }
+
+    ~asset_cache()
+    {
+        _running = false;
+        if (_watcher.joinable())
+        {
+            _watcher.join();
+        }
+        if (_inotify_fd >= 0)
+        {
+            close(_inotify_fd);
+        }
+    }
+
+    // 按请求路径查找文件，以'/'结尾的路径查找目录下的login.html，找不到返回空
+    asset_ptr find(const str_view &path)
+    {
+        std::string key = path.str();
+        if (key.empty() || key.back() == '/')
+        {
+            key += "login.html";
+        }
+        std::shared_ptr<const asset_table> table = std::atomic_load(&_table);
+        auto it = table->find(key);
+        if (it == table->end())
+        {
+            return asset_ptr();
+        }
+        return it->second;
+    }
+
+    // 解析Accept-Encoding，例如 gzip, deflate, br;q=0.9，q=0表示不接受
+    static int accept_encoding(const str_view &header)
+    {
+        int accepted = 0;
+        str_view rest = header, token;
+        while (string_util::next_token(rest, ',', token))
+        {
+            size_t semi = token.find(';');
+            str_view name = token.substr(0, semi).trim();
+            str_view q;
+            if (semi != str_view::npos && string_util::find_pair(token.substr(semi + 1), ';', "q", q) &&
+                (q == "0" || q == "0.0" || q == "0.00" || q == "0.000"))
+            {
+                continue;
+            }
+            if (name == "gzip")
+            {
+                accepted |= ASSET_GZIP;
+            }
+            else if (name == "br")
+            {
+                accepted |= ASSET_BR;
+            }
+        }
+        return accepted;
+    }
+
+    // 设置路径前缀的Cache-Control，已有的前缀会被覆盖，只能在服务器启动前调用
+    void set_cache_control(const std::string &prefix, const std::string &value)
+    {
+        for (auto &policy : _policies)
+        {
+            if (policy.first == prefix)
+            {
+                policy.second = value;
+                return;
+            }
+        }
+        _policies.push_back(std::make_pair(prefix, value));
+    }
+
+    // 按最长的前缀匹配出路径的Cache-Control，没有匹配时为nullptr
+    const std::string *cache_control(const str_view &path) const
+    {
+        const std::string *best = nullptr;
+        size_t best_len = 0;
+        for (auto &policy : _policies)
+        {
+            const std::string &prefix = policy.first;
+            if (prefix.size() <= path.size && memcmp(prefix.data(), path.data, prefix.size()) == 0 &&
+                (best == nullptr || prefix.size() > best_len))
+            {
+                best = &policy.second;
+                best_len = prefix.size();
+            }
+        }
+        return best;
+    }
+
+    // 404页面
+    asset_ptr not_found()
+    {
+        return std::atomic_load(&_not_found);
+    }
+
+    // 获取文件数、原始总字节数、gzip和brotli变体的总字节数(没有变体的文件按原始大小计)和重新加载次数
+    void stats(uint64_t &files, uint64_t &bytes, uint64_t &gzip_bytes, uint64_t &br_bytes, uint64_t &reloads)
+    {
+        std::shared_ptr<const asset_table> table = std::atomic_load(&_table);
+        files = table->size();
+        bytes = gzip_bytes = br_bytes = 0;
+        for (auto &it : *table)
+        {
+            const asset &a = *it.second;
+            bytes += a.body->size();
+            gzip_bytes += a.gzip.get() != nullptr ? a.gzip->size() : a.body->size();
+            br_bytes += a.br.get() != nullptr ? a.br->size() : a.body->size();
+        }
+        reloads = _reloads;
+    }
+};
@@ -0,0 +1,431 @@
+// 引擎基准测试：固定局面集的搜索速度和固定种子的自我对弈，结果输出为一行JSON，便于比较不同版本
+// 用法：bench [suite|selfplay|all|serve] [--games N] [--seed S] [--time MS] [--depth D] [--threads T]
+//                                         [--fixed D] [--opponent 另一个版本的bench] [--out 输出文件]
+// 指定--opponent时，自我对弈的B方由另一个版本的bench以serve模式运行，通过管道交换落子
+// --fixed D 按固定深度D搜索，不限时间、单线程，每一步只取决于局面，同一个种子的对局可以完全复现
+#define LOG_STREAM stderr // 日志输出到标准错误，标准输出只有一行JSON，可以直接交给jq
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <jsoncpp/json/json.h>
+
+#include "engine.hpp"
+
+#define BENCH_GAMES 10    // 自我对弈的默认局数
+#define BENCH_SEED 1      // 默认随机种子
+#define BENCH_TIME_MS 1000 // 每步默认思考时间
+#define BENCH_OPENING 4   // 自我对弈开局随机落子数，落在中央5x5内
+
+// 固定局面集，每个局面为双方依次的落子"行,列"，白方先手
+// 都是双方都没有连续冲四杀法的局面，保证会进入完整的alpha-beta搜索
+static const char *BENCH_SUITE[][2] = {
+    {"opening", "7,7 7,8 8,8"},
+    {"midgame_a", "8,9 7,4 6,10 4,9 6,6 5,9 4,7 7,9 8,5 8,8"},
+    {"midgame_b", "9,4 4,10 4,5 9,5 8,5 6,8 8,10 6,6 10,10 10,9"},
+    {"midgame_c", "9,4 8,5 7,8 4,5 4,4 4,6 9,7 10,4 10,8 7,9 10,9 7,7 7,10"},
+    {"midgame_d", "10,4 6,9 6,4 5,7 10,9 8,4 6,6 5,8 4,10 9,5 6,8 8,8"},
+    {"midgame_e", "5,6 6,5 9,9 10,4 5,8 10,9 10,6 4,8 8,6 7,8 7,5 10,5 4,5"},
+    {"late", "7,7 7,8 6,8 8,6 5,9 4,10 6,6 6,7 8,8 9,9 5,7 4,6 8,7 8,9 9,7 10,7 7,9 6,10"},
+};
+
+// 命令行参数
+struct bench_option
+{
+    std::string mode = "all";
+    int games = BENCH_GAMES;
+    unsigned seed = BENCH_SEED;
+    int time_ms = BENCH_TIME_MS;
+    int depth = SEARCH_MAX_DEPTH;
+    int threads = 1;
+    std::string opponent; // 另一个版本的bench路径，为空时双方都是本版本
+    std::string out;      // 输出文件，为空时输出到标准输出
+};
+
+// 解析"行,列 行,列 ..."格式的落子序列
+static std::vector<int> parse_moves(const std::string &text)
+{
+    std::vector<int> moves;
+    std::istringstream in(text);
+    std::string item;
+    while (in >> item)
+    {
+        int row = 0, col = 0;
+        if (sscanf(item.c_str(), "%d,%d", &row, &col) == 2)
+        {
+            moves.push_back(row * BOARD_COL + col);
+        }
+    }
+    return moves;
+}
+
+// 按落子序列摆出棋盘，返回下一步该走的颜色
+static int replay(const std::vector<int> &moves, bit_board &board)
+{
+    board.clear();
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        board.put(moves[i] / BOARD_COL, moves[i] % BOARD_COL, i % 2 == 0 ? WHITE_CHESS : BLACK_CHESS);
+    }
+    return moves.size() % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+}
+
+static double elapsed_ms(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 1.固定局面集：每个局面搜索一次，统计节点数、速度、置换表命中率和每一层的用时
+static Json::Value run_suite(const bench_option &opt)
+{
+    Json::Value suite(Json::arrayValue);
+    uint64_t total_nodes = 0, total_probes = 0, total_hits = 0;
+    double total_ms = 0;
+    level_config config = {opt.time_ms, opt.depth, opt.threads};
+    for (auto &position : BENCH_SUITE)
+    {
+        position_cache::instance().clear(); // 每个局面都从空缓存开始，结果与局面的顺序无关
+        bit_board board;
+        int color = replay(parse_moves(position[1]), board);
+        gobang_engine engine(board);
+        auto start = std::chrono::steady_clock::now();
+        search_result result = engine.search(color, config);
+        double ms = elapsed_ms(start);
+
+        Json::Value item;
+        item["name"] = position[0];
+        item["row"] = result.row;
+        item["col"] = result.col;
+        item["score"] = result.score;
+        item["depth"] = result.depth;
+        item["nodes"] = (Json::UInt64)result.nodes;
+        item["time_ms"] = ms;
+        item["nps"] = ms > 0 ? result.nodes * 1000.0 / ms : 0;
+        item["tt_hit_rate"] = result.tt_probes > 0 ? (double)result.tt_hits / result.tt_probes : 0;
+        Json::Value depth_ms(Json::arrayValue); // 第i项为搜完第i+1层的毫秒数
+        for (int d = 1; d <= SEARCH_MAX_DEPTH && engine.depth_time(d) >= 0; d++)
+        {
+            depth_ms.append(engine.depth_time(d) / 1000.0);
+        }
+        item["depth_ms"] = depth_ms;
+        suite.append(item);
+
+        total_nodes += result.nodes;
+        total_probes += result.tt_probes;
+        total_hits += result.tt_hits;
+        total_ms += ms;
+    }
+    Json::Value report;
+    report["positions"] = suite;
+    report["nodes"] = (Json::UInt64)total_nodes;
+    report["time_ms"] = total_ms;
+    report["nps"] = total_ms > 0 ? total_nodes * 1000.0 / total_ms : 0;
+    report["tt_hit_rate"] = total_probes > 0 ? (double)total_hits / total_probes : 0;
+    return report;
+}
+
+// 以serve模式运行的另一个版本，通过管道一问一答
+class bench_opponent
+{
+private:
+    pid_t _pid;
+    FILE *_in;  // 写给对方
+    FILE *_out; // 从对方读
+
+public:
+    bench_opponent(const std::string &path)
+        : _pid(-1), _in(nullptr), _out(nullptr)
+    {
+        int to_child[2], from_child[2];
+        if (pipe(to_child) < 0 || pipe(from_child) < 0)
+        {
+            return;
+        }
+        _pid = fork();
+        if (_pid == 0)
+        {
+            dup2(to_child[0], STDIN_FILENO);
+            dup2(from_child[1], STDOUT_FILENO);
+            close(to_child[1]);
+            close(from_child[0]);
+            execl(path.c_str(), path.c_str(), "serve", (char *)nullptr);
+            _exit(1);
+        }
+        close(to_child[0]);
+        close(from_child[1]);
+        _in = fdopen(to_child[1], "w");
+        _out = fdopen(from_child[0], "r");
+    }
+
+    ~bench_opponent()
+    {
+        if (_in != nullptr)
+        {
+            fclose(_in); // 对方读到EOF后退出
+        }
+        if (_out != nullptr)
+        {
+            fclose(_out);
+        }
+        if (_pid > 0)
+        {
+            waitpid(_pid, nullptr, 0);
+        }
+    }
+
+    // 请求对方在当前局面下棋，失败返回false
+    bool search(const std::vector<int> &moves, const int color, const level_config &config, int &row, int &col)
+    {
+        if (_in == nullptr || _out == nullptr)
+        {
+            return false;
+        }
+        fprintf(_in, "%d %d %d %d %d", config.time_ms, config.max_depth, config.threads, color, (int)moves.size());
+        for (int m : moves)
+        {
+            fprintf(_in, " %d", m);
+        }
+        fprintf(_in, "\n");
+        fflush(_in);
+        // 对方的日志也会写到标准输出，只认"move 行 列"这一行
+        char line[1024];
+        while (fgets(line, sizeof(line), _out) != nullptr)
+        {
+            if (sscanf(line, "move %d %d", &row, &col) == 2)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// serve模式：从标准输入读局面，向标准输出写"move 行 列"
+static int run_serve()
+{
+    int time_ms = 0, depth = 0, threads = 0, color = 0, count = 0;
+    while (std::cin >> time_ms >> depth >> threads >> color >> count)
+    {
+        std::vector<int> moves(count);
+        for (int i = 0; i < count; i++)
+        {
+            std::cin >> moves[i];
+        }
+        bit_board board;
+        replay(moves, board);
+        if (time_ms <= 0) // 固定深度：不沿用之前对局留下的缓存，保证可以复现
+        {
+            position_cache::instance().clear();
+        }
+        gobang_engine engine(board);
+        search_result result = engine.search(color, level_config{time_ms, depth, threads});
+        std::cout << "move " << result.row << " " << result.col << std::endl;
+    }
+    return 0;
+}
+
+// 2.自我对弈：固定种子生成随机开局，A、B双方轮流执白，统计A方胜率和双方的搜索速度
+static Json::Value run_selfplay(const bench_option &opt)
+{
+    std::unique_ptr<bench_opponent> opponent;
+    if (opt.opponent.empty() == false)
+    {
+        opponent.reset(new bench_opponent(opt.opponent));
+    }
+    level_config config = {opt.time_ms, opt.depth, opt.threads};
+    int wins_a = 0, wins_b = 0, draws = 0, errors = 0;
+    uint64_t nodes_a = 0, nodes_b = 0;
+    double ms_a = 0, ms_b = 0;
+    Json::Value games(Json::arrayValue);
+    for (int g = 0; g < opt.games; g++)
+    {
+        srand(opt.seed + g);
+        position_cache::instance().clear(); // 上一局缓存的局面会影响这一局，每局从空缓存开始
+        int color_a = g % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+        std::vector<int> moves;
+        bit_board board;
+        while ((int)moves.size() < BENCH_OPENING)
+        {
+            int row = BOARD_ROW / 2 - 2 + rand() % 5, col = BOARD_COL / 2 - 2 + rand() % 5;
+            if (board.empty(row, col))
+            {
+                board.put(row, col, moves.size() % 2 == 0 ? WHITE_CHESS : BLACK_CHESS);
+                moves.push_back(row * BOARD_COL + col);
+            }
+        }
+        int winner = 0;
+        while (winner == 0 && (int)moves.size() < BOARD_ROW * BOARD_COL)
+        {
+            int color = moves.size() % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+            int row = -1, col = -1;
+            auto start = std::chrono::steady_clock::now();
+            if (color == color_a || opponent == nullptr)
+            {
+                if (opt.time_ms <= 0) // 固定深度：和serve模式的对方一样，每一步都从空缓存开始
+                {
+                    position_cache::instance().clear();
+                }
+                gobang_engine engine(board);
+                search_result result = engine.search(color, config);
+                row = result.row;
+                col = result.col;
+                (color == color_a ? nodes_a : nodes_b) += result.nodes;
+            }
+            else if (opponent->search(moves, color, config, row, col) == false)
+            {
+                break;
+            }
+            (color == color_a ? ms_a : ms_b) += elapsed_ms(start);
+            if (bit_board::in_board(row, col) == false || board.empty(row, col) == false)
+            {
+                break;
+            }
+            board.put(row, col, color);
+            moves.push_back(row * BOARD_COL + col);
+            if (board.check_five(row, col, color))
+            {
+                winner = color;
+            }
+        }
+        Json::Value game;
+        game["seed"] = opt.seed + g;
+        game["a_color"] = color_a == WHITE_CHESS ? "white" : "black";
+        game["moves"] = (int)moves.size();
+        if (winner == 0 && (int)moves.size() < BOARD_ROW * BOARD_COL)
+        {
+            errors++; // 对方非法落子或者通信失败
+            game["result"] = "error";
+        }
+        else if (winner == 0)
+        {
+            draws++;
+            game["result"] = "draw";
+        }
+        else if (winner == color_a)
+        {
+            wins_a++;
+            game["result"] = "a";
+        }
+        else
+        {
+            wins_b++;
+            game["result"] = "b";
+        }
+        games.append(game);
+    }
+    Json::Value report;
+    report["games"] = games;
+    report["opponent"] = opt.opponent.empty() ? "self" : opt.opponent;
+    report["wins_a"] = wins_a;
+    report["wins_b"] = wins_b;
+    report["draws"] = draws;
+    report["errors"] = errors;
+    int finished = wins_a + wins_b + draws;
+    report["win_rate_a"] = finished > 0 ? (wins_a + 0.5 * draws) / finished : 0;
+    report["nps_a"] = ms_a > 0 ? nodes_a * 1000.0 / ms_a : 0;
+    if (opponent == nullptr) // 外部版本的节点数拿不到
+    {
+        report["nps_b"] = ms_b > 0 ? nodes_b * 1000.0 / ms_b : 0;
+    }
+    report["time_ms_a"] = ms_a;
+    report["time_ms_b"] = ms_b;
+    return report;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_option opt;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--games" && has_value)
+        {
+            opt.games = atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && has_value)
+        {
+            opt.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--time" && has_value)
+        {
+            opt.time_ms = atoi(argv[++i]);
+        }
+        else if (arg == "--depth" && has_value)
+        {
+            opt.depth = atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && has_value)
+        {
+            opt.threads = atoi(argv[++i]);
+        }
+        else if (arg == "--fixed" && has_value)
+        {
+            opt.depth = atoi(argv[++i]);
+            opt.time_ms = 0;
+        }
+        else if (arg == "--opponent" && has_value)
+        {
+            opt.opponent = argv[++i];
+        }
+        else if (arg == "--out" && has_value)
+        {
+            opt.out = argv[++i];
+        }
+        else if (arg == "suite" || arg == "selfplay" || arg == "all" || arg == "serve")
+        {
+            opt.mode = arg;
+        }
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (opt.mode == "serve")
+    {
+        return run_serve();
+    }
+    if (opt.time_ms <= 0) // 不限时间时只按深度搜索，多线程的搜索顺序不确定，固定为单线程
+    {
+        opt.time_ms = 0;
+        opt.threads = 1;
+    }
+    signal(SIGPIPE, SIG_IGN); // 对方进程异常退出时不让本进程被杀死
+
+    Json::Value report;
+    report["build"] = __DATE__ " " __TIME__;
+    report["seed"] = opt.seed;
+    report["time_ms"] = opt.time_ms;
+    report["depth"] = opt.depth;
+    report["threads"] = opt.threads;
+    if (opt.mode == "suite" || opt.mode == "all")
+    {
+        report["suite"] = run_suite(opt);
+    }
+    if (opt.mode == "selfplay" || opt.mode == "all")
+    {
+        report["selfplay"] = run_selfplay(opt);
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = ""; // 一次运行一行，方便追加到文件里比较
+    std::string body = Json::writeString(builder, report);
+    if (opt.out.empty())
+    {
+        std::cout << body << std::endl;
+    }
+    else
+    {
+        std::ofstream(opt.out, std::ios::app) << body << std::endl;
+    }
+    return 0;
+}
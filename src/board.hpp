@@ -0,0 +1,349 @@
+// 棋盘模块，使用位棋盘存储棋子
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#define BOARD_ROW 15  // 默认棋盘(机器人引擎使用)的行数
+#define BOARD_COL 15  // 默认棋盘的列数
+#define WHITE_CHESS 1 // 白方的棋子
+#define BLACK_CHESS 2 // 黑方的棋子
+
+#define BOARD_DIAG (BOARD_ROW + BOARD_COL - 1) // 斜线条数
+
+// Zobrist键值表：每种颜色在每个位置各有一个随机数，局面的键值是所有棋子对应随机数的异或
+// 每种棋盘大小各有一张表
+template <int SIZE>
+class zobrist
+{
+private:
+    uint64_t _keys[2][SIZE * SIZE];
+
+    zobrist()
+    {
+        uint64_t seed = 0x9E3779B97F4A7C15ULL; // 固定种子，保证每次启动键值相同
+        for (int c = 0; c < 2; c++)
+        {
+            for (int i = 0; i < SIZE * SIZE; i++)
+            {
+                // splitmix64
+                seed += 0x9E3779B97F4A7C15ULL;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                _keys[c][i] = z ^ (z >> 31);
+            }
+        }
+    }
+
+public:
+    // 获取某颜色棋子在(row, col)的键值
+    static uint64_t key(const int chess_color, const int row, const int col)
+    {
+        static zobrist table;
+        return table._keys[chess_color - 1][row * SIZE + col];
+    }
+};
+
+// 四个方向，与原先five()中的偏移量一一对应
+enum board_dir
+{
+    DIR_COL = 0, // 竖线   (1, 0)
+    DIR_ROW,     // 横线   (0, 1)
+    DIR_DIAG,    // 主对角线 (-1, -1)
+    DIR_ANTI,    // 副对角线 (-1, 1)
+    DIR_COUNT
+};
+
+// 位棋盘：每种颜色各存一份按线组织的位图，一条线上的棋子就是一个整数的若干位
+// 横线以列号为位，竖线以行号为位，两条斜线也以列号为位
+// 这样落子和判断连珠都只需要对整条线做移位和按位与，不再逐格遍历
+// 同时增量维护局面的Zobrist键值，用于置换表和局面缓存
+// 棋盘边长SIZE是模板参数，16路以内每条线用16位整数，更大的棋盘用32位整数
+template <int SIZE>
+class basic_board
+{
+public:
+    static_assert(SIZE >= 5 && SIZE <= 31, "一条线必须放得进32位整数");
+    static constexpr int DIAG = 2 * SIZE - 1; // 斜线条数
+    typedef typename std::conditional<SIZE <= 16, uint16_t, uint32_t>::type line_t;
+
+private:
+    line_t _row[2][SIZE];  // 横线视图，_row[颜色][行]的第col位
+    line_t _col[2][SIZE];  // 竖线视图，_col[颜色][列]的第row位
+    line_t _diag[2][DIAG]; // 主对角线视图，下标为 row-col+SIZE-1，第col位
+    line_t _anti[2][DIAG]; // 副对角线视图，下标为 row+col，第col位
+    int _count;            // 棋盘上的棋子数
+    uint64_t _key;         // 局面的Zobrist键值
+
+public:
+    basic_board()
+    {
+        clear();
+    }
+
+    // 清空棋盘
+    void clear()
+    {
+        memset(_row, 0, sizeof(_row));
+        memset(_col, 0, sizeof(_col));
+        memset(_diag, 0, sizeof(_diag));
+        memset(_anti, 0, sizeof(_anti));
+        _count = 0;
+        _key = 0;
+        return;
+    }
+
+    // 判断位置是否在棋盘内
+    static bool in_board(const int row, const int col)
+    {
+        return row >= 0 && row < SIZE && col >= 0 && col < SIZE;
+    }
+
+    // 获取某个位置的棋子，没有棋子返回0
+    int at(const int row, const int col) const
+    {
+        int white = (_row[0][row] >> col) & 1;
+        int black = (_row[1][row] >> col) & 1;
+        return white * WHITE_CHESS + black * BLACK_CHESS;
+    }
+
+    // 判断某个位置是否为空
+    bool empty(const int row, const int col) const
+    {
+        return (((_row[0][row] | _row[1][row]) >> col) & 1) == 0;
+    }
+
+    // 获取棋盘上的棋子数
+    int count() const
+    {
+        return _count;
+    }
+
+    // 获取局面的Zobrist键值，双方轮流下棋，棋子相同的局面轮到的一方也相同，所以不需要单独区分
+    uint64_t key() const
+    {
+        return _key;
+    }
+
+    // 落子，调用者需保证位置在棋盘内且为空
+    void put(const int row, const int col, const int chess_color)
+    {
+        int c = chess_color - 1;
+        _row[c][row] |= (line_t)(1u << col);
+        _col[c][col] |= (line_t)(1u << row);
+        _diag[c][row - col + SIZE - 1] |= (line_t)(1u << col);
+        _anti[c][row + col] |= (line_t)(1u << col);
+        _count++;
+        _key ^= zobrist<SIZE>::key(chess_color, row, col);
+        return;
+    }
+
+    // 提子，用于搜索时撤销落子
+    void remove(const int row, const int col, const int chess_color)
+    {
+        int c = chess_color - 1;
+        _row[c][row] &= (line_t)~(1u << col);
+        _col[c][col] &= (line_t)~(1u << row);
+        _diag[c][row - col + SIZE - 1] &= (line_t)~(1u << col);
+        _anti[c][row + col] &= (line_t)~(1u << col);
+        _count--;
+        _key ^= zobrist<SIZE>::key(chess_color, row, col);
+        return;
+    }
+
+    // 获取某方向上线的条数
+    static int line_count(const board_dir dir)
+    {
+        return dir == DIR_COL || dir == DIR_ROW ? SIZE : DIAG;
+    }
+
+    // 获取(row, col)所在的某方向线的下标
+    static int line_index(const int row, const int col, const board_dir dir)
+    {
+        switch (dir)
+        {
+        case DIR_COL:
+            return col;
+        case DIR_ROW:
+            return row;
+        case DIR_DIAG:
+            return row - col + SIZE - 1;
+        default:
+            return row + col;
+        }
+    }
+
+    // 获取(row, col)在某方向线上对应的位，竖线以行号为位，其余以列号为位
+    static int line_pos(const int row, const int col, const board_dir dir)
+    {
+        return dir == DIR_COL ? row : col;
+    }
+
+    // 获取某方向第index条线上落在棋盘内的位，斜线两端的位不在棋盘内
+    static uint32_t line_mask(const board_dir dir, const int index)
+    {
+        int lo = 0, hi = SIZE - 1;
+        if (dir == DIR_DIAG) // row - col = index - (SIZE - 1)
+        {
+            int d = index - (SIZE - 1);
+            lo = d < 0 ? -d : 0;
+            hi = SIZE - 1 - d < hi ? SIZE - 1 - d : hi;
+        }
+        else if (dir == DIR_ANTI) // row + col = index
+        {
+            lo = index - (SIZE - 1) > 0 ? index - (SIZE - 1) : 0;
+            hi = index < hi ? index : hi;
+        }
+        return (uint32_t)(((1ull << (hi + 1)) - 1) & ~((1ull << lo) - 1));
+    }
+
+    // 获取某种颜色在某方向第index条线上的位图
+    uint32_t line_bits(const int chess_color, const board_dir dir, const int index) const
+    {
+        int c = chess_color - 1;
+        switch (dir)
+        {
+        case DIR_COL:
+            return _col[c][index];
+        case DIR_ROW:
+            return _row[c][index];
+        case DIR_DIAG:
+            return _diag[c][index];
+        default:
+            return _anti[c][index];
+        }
+    }
+
+    // 获取经过(row, col)的某方向整条线的位图，以及该位置在线上对应的位
+    uint32_t line(const int row, const int col, const int chess_color, const board_dir dir, int &pos) const
+    {
+        pos = line_pos(row, col, dir);
+        return line_bits(chess_color, dir, line_index(row, col, dir));
+    }
+
+    // 计算经过(row, col)的某方向同色连子数，(row, col)上必须是chess_color的棋子
+    int run_length(const int row, const int col, const int chess_color, const board_dir dir) const
+    {
+        int pos = 0;
+        uint32_t bits = line(row, col, chess_color, dir, pos);
+        return run_at(bits, pos);
+    }
+
+    // 计算位图bits中经过第pos位的连续1的个数，第pos位必须为1
+    // 向高位数连续的1用ctz，向低位数连续的1用clz，整条线一次移位即可算出
+    static int run_at(const uint32_t bits, const int pos)
+    {
+        int up = __builtin_ctz(~(bits >> pos));
+        int down = __builtin_clz(~(bits << (31 - pos)));
+        return up + down - 1;
+    }
+
+    // 判断(row, col)所在的四条线上是否恰好五子连珠
+    bool check_five(const int row, const int col, const int chess_color) const
+    {
+        return (run_length(row, col, chess_color, DIR_COL) == 5) |
+               (run_length(row, col, chess_color, DIR_ROW) == 5) |
+               (run_length(row, col, chess_color, DIR_DIAG) == 5) |
+               (run_length(row, col, chess_color, DIR_ANTI) == 5);
+    }
+};
+
+// 机器人引擎和棋型估值使用的15路棋盘
+typedef basic_board<BOARD_ROW> bit_board;
+
+// 四个方向的行列偏移量
+static const int DIR_OFFSET[DIR_COUNT][2] = {{1, 0}, {0, 1}, {-1, -1}, {-1, 1}};
+
+// 沿某方向的线移动step位后的坐标，线上的位竖线以行号计，其余以列号计
+inline void line_step(const board_dir dir, const int step, int &row, int &col)
+{
+    switch (dir)
+    {
+    case DIR_COL:
+        row += step;
+        break;
+    case DIR_ROW:
+        col += step;
+        break;
+    case DIR_DIAG: // row - col 不变
+        row += step;
+        col += step;
+        break;
+    default: // row + col 不变
+        row -= step;
+        col += step;
+        break;
+    }
+    return;
+}
+
+// 连子长度记录：每个方向上，每段连子的两个端点格子记录这段连子的长度
+// 落子时只需读取两侧相邻格子(必然是端点)上的长度，合并后写回新的两个端点，每个方向O(1)
+// 棋子颜色直接读对局的位棋盘，这里只存长度
+// 只支持落子不支持提子，用于房间里真实对局的胜负判断
+template <int SIZE>
+class basic_run_tracker
+{
+private:
+    uint8_t _run[DIR_COUNT][SIZE][SIZE]; // 端点格子上的连子长度，非端点格子的值无意义
+
+    // (row, col)在棋盘内且是chess_color的棋子
+    static bool own(const basic_board<SIZE> &board, const int row, const int col, const int chess_color)
+    {
+        return basic_board<SIZE>::in_board(row, col) && board.at(row, col) == chess_color;
+    }
+
+public:
+    basic_run_tracker()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        memset(_run, 0, sizeof(_run));
+        return;
+    }
+
+    // 棋子落在board的(row, col)之后调用，更新四个方向的连子长度
+    void put(const basic_board<SIZE> &board, const int row, const int col, const int chess_color)
+    {
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            int dr = DIR_OFFSET[d][0];
+            int dc = DIR_OFFSET[d][1];
+            // 落子前(row, col)为空，所以两侧相邻的同色棋子一定是各自连子的端点
+            int prev = own(board, row - dr, col - dc, chess_color) ? _run[d][row - dr][col - dc] : 0;
+            int next = own(board, row + dr, col + dc, chess_color) ? _run[d][row + dr][col + dc] : 0;
+            uint8_t len = (uint8_t)(prev + 1 + next);
+            _run[d][row - prev * dr][col - prev * dc] = len;
+            _run[d][row + next * dr][col + next * dc] = len;
+            _run[d][row][col] = len;
+        }
+        return;
+    }
+
+    // 获取刚落下的(row, col)在某方向上的连子长度，只在该棋子落下后、下一次落子前有效
+    int run(const int row, const int col, const board_dir dir) const
+    {
+        return _run[dir][row][col];
+    }
+
+    // 刚落下的棋子是否恰好五子连珠
+    bool five(const int row, const int col) const
+    {
+        return (run(row, col, DIR_COL) == 5) | (run(row, col, DIR_ROW) == 5) |
+               (run(row, col, DIR_DIAG) == 5) | (run(row, col, DIR_ANTI) == 5);
+    }
+
+    // 刚落下的棋子是否形成长连(六子及以上)
+    bool overline(const int row, const int col) const
+    {
+        return (run(row, col, DIR_COL) > 5) | (run(row, col, DIR_ROW) > 5) |
+               (run(row, col, DIR_DIAG) > 5) | (run(row, col, DIR_ANTI) > 5);
+    }
+};
+
+typedef basic_run_tracker<BOARD_ROW> run_tracker;
@@ -0,0 +1,92 @@
+// 机器人模块，机器人的思考放在独立的线程中，不占用websocket的io线程
+#pragma once
+
+#include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "engine.hpp"
+#include "log.hpp"
+
+#define BOT_USER_ID ((uint64_t)1 << 50)  // 机器人的用户id，数据库自增id用不到，且前端js能精确表示
+#define BOT_MATCH_TIMEOUT 10000          // 匹配队列中只有一个玩家等待多久后为他匹配机器人(毫秒)
+
+// 机器人线程池，房间把搜索任务投递进来，由线程池中的线程执行
+class bot_worker
+{
+private:
+    std::list<std::function<void()>> _tasks; // 待执行的搜索任务
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::vector<std::thread> _threads;
+    bool _stop;
+
+public:
+    bot_worker(const int thread_count = BOT_THREADS)
+        : _stop(false)
+    {
+        for (int i = 0; i < thread_count; i++)
+        {
+            _threads.push_back(std::thread(&bot_worker::handler_task, this));
+        }
+        DLOG("机器人模块初始化完毕！！！");
+    }
+
+    ~bot_worker()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+            _cond.notify_all();
+        }
+        for (auto &t : _threads)
+        {
+            t.join();
+        }
+        DLOG("机器人模块销毁完毕！！！");
+    }
+
+    // 投递任务
+    void post(const std::function<void()> &task)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _tasks.push_back(task);
+        _cond.notify_one();
+        return;
+    }
+
+    // 获取排队中的任务数
+    size_t pending()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _tasks.size();
+    }
+
+private:
+    // 线程入口，不断取出任务执行
+    void handler_task()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (_tasks.empty() && _stop == false)
+                {
+                    _cond.wait(lock);
+                }
+                if (_stop == true)
+                {
+                    return;
+                }
+                task = _tasks.front();
+                _tasks.pop_front();
+            }
+            task();
+        }
+        return;
+    }
+};
@@ -0,0 +1,131 @@
+// 局面缓存模块，所有房间的机器人共享已经算过的局面
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "log.hpp"
+
+#define POSITION_CACHE_BITS 18     // 缓存大小为2^18项，每项16字节，共4MB
+#define POSITION_CACHE_STRIPES 256 // 锁的个数，按键值分段加锁
+
+// 缓存的局面信息
+struct position_info
+{
+    int row;   // 最佳落子位置
+    int col;
+    int score; // 站在落子方角度的分数
+    int depth; // 搜索深度
+};
+
+// 进程内共享的局面缓存：固定大小的哈希表，按Zobrist键值定位，同一位置上深度更深的结果优先保留
+// 表的大小在构造时确定，不会随使用增长；每一段用一把锁保护，不同房间的查询很少互相等待
+class position_cache
+{
+private:
+    struct entry
+    {
+        uint64_t key;  // 局面键值，0表示空
+        int32_t score;
+        int8_t row;
+        int8_t col;
+        int8_t depth;
+        int8_t unused;
+    };
+    std::vector<entry> _table;
+    uint64_t _mask;
+    std::mutex _locks[POSITION_CACHE_STRIPES];
+    std::atomic<uint64_t> _hits;   // 命中次数
+    std::atomic<uint64_t> _misses; // 未命中次数
+    std::atomic<uint64_t> _stores; // 写入次数
+    std::atomic<uint64_t> _used;   // 已使用的项数
+
+    position_cache(const int bits = POSITION_CACHE_BITS)
+        : _table((size_t)1 << bits, entry{0, 0, 0, 0, 0, 0}), _mask(((uint64_t)1 << bits) - 1),
+          _hits(0), _misses(0), _stores(0), _used(0)
+    {
+        DLOG("局面缓存初始化完毕，共%lu项", (unsigned long)_table.size());
+    }
+
+public:
+    // 获取进程内唯一的局面缓存
+    static position_cache &instance()
+    {
+        static position_cache cache;
+        return cache;
+    }
+
+    // 清空所有局面，基准测试用它让每局对弈互不影响
+    void clear()
+    {
+        for (size_t index = 0; index < _table.size(); index++)
+        {
+            std::unique_lock<std::mutex> lock(_locks[index % POSITION_CACHE_STRIPES]);
+            _table[index] = entry{0, 0, 0, 0, 0, 0};
+        }
+        _used.store(0, std::memory_order_relaxed);
+    }
+
+    // 查找局面，找到返回true
+    bool lookup(const uint64_t key, position_info &info)
+    {
+        size_t index = key & _mask;
+        std::unique_lock<std::mutex> lock(_locks[index % POSITION_CACHE_STRIPES]);
+        const entry &e = _table[index];
+        if (key == 0 || e.key != key)
+        {
+            _misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        info.row = e.row;
+        info.col = e.col;
+        info.score = e.score;
+        info.depth = e.depth;
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 保存局面，同一位置上已有更深的其他结果时不覆盖
+    void store(const uint64_t key, const position_info &info)
+    {
+        if (key == 0)
+        {
+            return;
+        }
+        size_t index = key & _mask;
+        std::unique_lock<std::mutex> lock(_locks[index % POSITION_CACHE_STRIPES]);
+        entry &e = _table[index];
+        if (e.key != 0 && e.key != key && e.depth > info.depth)
+        {
+            return;
+        }
+        if (e.key == key && e.depth > info.depth) // 同一局面只保留更深的结果
+        {
+            return;
+        }
+        if (e.key == 0)
+        {
+            _used.fetch_add(1, std::memory_order_relaxed);
+        }
+        e.key = key;
+        e.score = info.score;
+        e.row = (int8_t)info.row;
+        e.col = (int8_t)info.col;
+        e.depth = (int8_t)info.depth;
+        _stores.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // 获取缓存的统计信息，用于调整缓存大小
+    void stats(uint64_t &capacity, uint64_t &used, uint64_t &hits, uint64_t &misses, uint64_t &stores)
+    {
+        capacity = _table.size();
+        used = _used.load(std::memory_order_relaxed);
+        hits = _hits.load(std::memory_order_relaxed);
+        misses = _misses.load(std::memory_order_relaxed);
+        stores = _stores.load(std::memory_order_relaxed);
+        return;
+    }
+};
@@ -3,36 +3,130 @@
 #include <stdio.h>
 
 #include <string>
-#include <mutex>
 #include <memory>
+#include <vector>
 
 #include "util.hpp"
 #include "log.hpp"
+#include "mysql_pool.hpp"
+#include "user_cache.hpp"
+
+#define USERNAME_MAX 256 // 查询结果中用户名的缓冲区大小
+#define SCORE_DELTA 30   // 每局胜负加减的分数
+#define RESULT_ROWS_PER_UPDATE 100 // 批量结算时一条update语句最多包含的用户数
+
+// user表的预处理语句编号，每条连接第一次用到时准备一次，之后只传参数，服务器不再重新解析语句
+enum user_stmt
+{
+    STMT_INSERT_USER = 0,
+    STMT_LOGIN,
+    STMT_SELECT_BY_NAME,
+    STMT_SELECT_BY_ID,
+    STMT_USER_WIN,
+    STMT_USER_LOSE
+};
+
+#define INSERT_USER "insert into user values(null,?,SHA2(?,512),1000,0,0);"
+#define LOGIN_USER "select id,score,total_count,win_count from user where username=? and password=SHA2(?,512);"
+#define SELECT_BY_NAME "select id,score,total_count,win_count from user where username=?;"
+#define SELECT_BY_ID "select username,score,total_count,win_count from user where id=?;"
+#define USER_WIN "update user set score=score+30,total_count=total_count+1,win_count=win_count+1 where id=?;"
+#define USER_LOSE "update user set score=score-30,total_count=total_count+1 where id=?;"
+
+// 一个用户在一批对局结果中的胜负场数
+struct user_result
+{
+    uint64_t id;
+    int wins;
+    int losses;
+};
+
+// 查询结果的一行，直接绑定为整数，不再把结果字符串转换成整数
+struct user_row
+{
+    uint64_t id;
+    int64_t score;
+    int total_count;
+    int win_count;
+    char username[USERNAME_MAX];
+    unsigned long username_len;
+
+    // 绑定id(或username)、score、total_count、win_count四列
+    void bind(MYSQL_BIND *results, const bool with_username)
+    {
+        if (with_username)
+        {
+            mysql_util::bind_string(results[0], username, sizeof(username), &username_len);
+        }
+        else
+        {
+            mysql_util::bind_int64(results[0], &id, true);
+        }
+        mysql_util::bind_int64(results[1], &score, false);
+        mysql_util::bind_int(results[2], &total_count);
+        mysql_util::bind_int(results[3], &win_count);
+    }
+
+    void to_json(Json::Value &user) const
+    {
+        user["id"] = (Json::UInt64)id;
+        user["score"] = (Json::UInt64)score;
+        user["total_count"] = total_count;
+        user["win_count"] = win_count;
+    }
+
+    user_profile to_profile(const std::string &name) const
+    {
+        return user_profile{name, score, total_count, win_count};
+    }
+};
 
 // 管理数据库user表类，通过这个类的实例化来管理我们的user表
 class user_table
 {
 private:
-    MYSQL *_mysql;     // mysql句柄
-    std::mutex _mutex; // 互斥锁，保证访问数据库安全
+    mysql_pool _pool;  // 连接池，每次操作借用一条连接，不同线程的查询可以并行
+    user_cache _cache; // 用户信息缓存，按id查询时先查缓存，没有时从数据库读出后放入
+
+    // 按id更新战绩
+    bool update_by_id(const int id, const char *sql, const uint64_t &uid)
+    {
+        mysql_guard conn = _pool.acquire();
+        if (!conn)
+        {
+            return false;
+        }
+        MYSQL_STMT *stmt = conn.prepare(id, sql);
+        if (stmt == nullptr)
+        {
+            return false;
+        }
+        uint64_t value = uid;
+        MYSQL_BIND params[1];
+        mysql_util::bind_int64(params[0], &value, true);
+        return conn.execute(stmt, params);
+    }
 
 public:
-    // 构造函数，连接数据库
+    // 构造函数，建立连接池
     user_table(const std::string &host,
                const std::string &username,
                const std::string &password,
                const std::string &dbname,
-               const uint16_t &port = 3306)
+               const uint16_t &port = 3306,
+               const size_t pool_size = MYSQL_POOL_SIZE)
+        : _pool(host, username, password, dbname, port, pool_size)
     {
-        _mysql = mysql_util::mysql_create(host, username, password, dbname, port);
-        assert(_mysql != nullptr);
     }
 
-    // 释放连接数据库
-    ~user_table()
+    mysql_pool &pool()
     {
-        mysql_util::mysql_destroy(_mysql);
-        _mysql = nullptr;
+        return _pool;
+    }
+
+    user_cache &cache()
+    {
+        return _cache;
     }
 
     // 注册用户时，插入数据
@@ -45,18 +139,26 @@ public:
             return false;
         }
 
-// 如果用户名和密码不为空，则进行插入数据
-#define INSERT_USER "insert into user values(null,'%s',SHA2('%s',512),1000,0,0);"
-        char sql[4096] = {0}; // 要执行的sql语句
-        sprintf(sql, INSERT_USER, user["username"].asCString(), user["password"].asCString());
+        // 如果用户名和密码不为空，则进行插入数据，用户名和密码作为参数传入，不拼接到语句中
+        std::string username = user["username"].asString();
+        std::string password = user["password"].asString();
+        unsigned long username_len = username.size(), password_len = password.size();
+        MYSQL_BIND params[2];
+        mysql_util::bind_string(params[0], &username[0], username_len, &username_len);
+        mysql_util::bind_string(params[1], &password[0], password_len, &password_len);
 
-        bool ret = mysql_util::mysql_exec(_mysql, sql);
-        if (ret == false)
+        mysql_guard conn = _pool.acquire();
+        if (!conn)
+        {
+            return false;
+        }
+        MYSQL_STMT *stmt = conn.prepare(STMT_INSERT_USER, INSERT_USER);
+        if (stmt == nullptr || conn.execute(stmt, params) == false)
         {
-            DLOG("insert user failed : %s , reason : %s", sql, mysql_error(_mysql));
+            DLOG("insert user failed : %s", username.c_str());
             return false;
         }
-        DLOG("insert user success : %s", sql);
+        DLOG("insert user success : %s", username.c_str());
         return true;
     }
 
@@ -70,145 +172,110 @@ public:
             return false;
         }
 
-// 执行select搜索语句
-#define LOGIN_USER "select id,score,total_count,win_count from user where username='%s' and password=SHA2('%s',512);"
-        char sql[4096] = {0};
-        sprintf(sql, LOGIN_USER, user["username"].asCString(), user["password"].asCString());
+        std::string username = user["username"].asString();
+        std::string password = user["password"].asString();
+        unsigned long username_len = username.size(), password_len = password.size();
+        MYSQL_BIND params[2];
+        mysql_util::bind_string(params[0], &username[0], username_len, &username_len);
+        mysql_util::bind_string(params[1], &password[0], password_len, &password_len);
+        user_row row;
+        MYSQL_BIND results[4];
+        row.bind(results, false);
 
-        // 执行select语句后，需要获取搜索出来的信息，称结果集
-        MYSQL_RES *res = nullptr;
+        // 语句和结果都在借用的连接上，其他线程用的是别的连接，不需要互斥
+        mysql_guard conn = _pool.acquire();
+        if (!conn)
         {
-            // 进行select查询的时候，要进行互斥，因为我们要通过res获取查询出来的信息，如果不进行互斥有可能res获取的信息是不符合的
-            std::unique_lock<std::mutex> lock(_mutex);
-            bool ret = mysql_util::mysql_exec(_mysql, sql);
-            if (ret == false)
-            {
-                DLOG("login failed");
-                return false;
-            }
-            res = mysql_store_result(_mysql); // 获取结果集
-            if (res == nullptr)
-            {
-                DLOG("The user information does not exist");
-                return false;
-            }
+            return false;
         }
-        // 判断结果集数据是否为1
-        int row_num = mysql_num_rows(res);
-        if (row_num != 1) // 说明数据库中，有两个相同的username和password
+        MYSQL_STMT *stmt = conn.prepare(STMT_LOGIN, LOGIN_USER);
+        if (stmt == nullptr || conn.execute(stmt, params, results) == false) // 用户不存在或者不唯一
         {
-            DLOG("This user information is not unique");
+            DLOG("login failed");
             return false;
         }
 
         // 将用户信息写回json user
-        MYSQL_ROW row = mysql_fetch_row(res);
-        user["id"] = (Json::UInt64)std::stol(row[0]);
-        user["score"] = (Json::UInt64)std::stol(row[1]);
-        user["total_count"] = std::stoi(row[2]);
-        user["win_count"] = std::stoi(row[3]);
-        mysql_free_result(res); // 释放结果集
+        row.to_json(user);
         return true;
     }
 
     // 通过用户名查找用户数据
     bool select_by_name(const std::string &username, Json::Value &user)
     {
-#define SELECT_BY_NAME "select id,score,total_count,win_count from user where username='%s';"
-        char sql[4096] = {0};
-        sprintf(sql, SELECT_BY_NAME, username);
+        std::string name = username;
+        unsigned long name_len = name.size();
+        MYSQL_BIND params[1];
+        mysql_util::bind_string(params[0], &name[0], name_len, &name_len);
+        user_row row;
+        MYSQL_BIND results[4];
+        row.bind(results, false);
 
-        MYSQL_RES *res = nullptr;
+        mysql_guard conn = _pool.acquire();
+        if (!conn)
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            bool ret = mysql_util::mysql_exec(_mysql, sql);
-            if (ret == false)
-            {
-                DLOG("get user by name failed");
-                return false;
-            }
-            // 获取结果集
-            res = mysql_store_result(_mysql);
-            if (res == nullptr)
-            {
-                DLOG("the user %s is not exist", username);
-                return true;
-            }
+            return false;
         }
-
-        // 判断数据是否只有一条
-        int row_num = mysql_num_rows(res);
-        if (row_num != 1)
+        MYSQL_STMT *stmt = conn.prepare(STMT_SELECT_BY_NAME, SELECT_BY_NAME);
+        if (stmt == nullptr || conn.execute(stmt, params, results) == false)
         {
-            DLOG("the user information is not unique");
+            DLOG("get user by name failed : %s", username.c_str());
             return false;
         }
 
         // 将信息写回json中
-        MYSQL_ROW row = mysql_fetch_row(res);
-        user["id"] = (Json::UInt64)std::stol(row[0]);
+        row.to_json(user);
         user["username"] = username;
-        user["score"] = (Json::UInt64)std::stol(row[1]);
-        user["total_count"] = std::stoi(row[2]);
-        user["win_count"] = std::stoi(row[3]);
-
-        mysql_free_result(res);
         return true;
     }
 
-    // 通过用户id查找用户数据
+    // 通过用户id查找用户数据，先查缓存
     bool select_by_id(const uint64_t &id, Json::Value &user)
     {
-#define SELECT_BY_ID "select username,score,total_count,win_count from user where id=%d;"
-        char sql[4096] = {0};
-        sprintf(sql, SELECT_BY_ID, id);
-
-        MYSQL_RES *res = nullptr;
+        user_profile profile;
+        if (_cache.get(id, profile))
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            bool ret = mysql_util::mysql_exec(_mysql, sql);
-            if (ret == false)
-            {
-                DLOG("get user by id failed");
-                return false;
-            }
-            // 获取结果集
-            res = mysql_store_result(_mysql);
-            if (res == nullptr)
-            {
-                DLOG("the user %d is not exist", id);
-                return true;
-            }
+            user["id"] = (Json::UInt64)id;
+            user["username"] = profile.username;
+            user["score"] = (Json::UInt64)profile.score;
+            user["total_count"] = profile.total_count;
+            user["win_count"] = profile.win_count;
+            return true;
         }
+        uint64_t version = _cache.version(id); // 查询期间战绩有变化时，查到的信息不放入缓存
+        uint64_t uid = id;
+        MYSQL_BIND params[1];
+        mysql_util::bind_int64(params[0], &uid, true);
+        user_row row;
+        MYSQL_BIND results[4];
+        row.bind(results, true);
 
-        // 判断数据是否只有一条
-        int row_num = mysql_num_rows(res);
-        if (row_num != 1)
+        mysql_guard conn = _pool.acquire();
+        if (!conn)
+        {
+            return false;
+        }
+        MYSQL_STMT *stmt = conn.prepare(STMT_SELECT_BY_ID, SELECT_BY_ID);
+        if (stmt == nullptr || conn.execute(stmt, params, results) == false)
         {
-            DLOG("the user information is not unique");
+            DLOG("get user by id failed : %lu", id);
             return false;
         }
 
         // 将信息写回json中
-        MYSQL_ROW row = mysql_fetch_row(res);
-        user["id"] = (Json::UInt64)id;
-        user["username"] = row[0];
-        user["score"] = (Json::UInt64)std::stol(row[1]);
-        user["total_count"] = std::stoi(row[2]);
-        user["win_count"] = std::stoi(row[3]);
-
-        mysql_free_result(res);
+        row.id = id;
+        row.to_json(user);
+        std::string username(row.username, std::min<unsigned long>(row.username_len, sizeof(row.username)));
+        user["username"] = username;
+        _cache.put(id, row.to_profile(username), version);
         return true;
     }
 
     // 胜利时，分数+30，胜场+1，总场数+1
     bool win(const uint64_t &id)
     {
-#define USER_WIN "update user set score=score+30,total_count=total_count+1,win_count=win_count+1 where id = %d;"
-        char sql[4096] = {0};
-        sprintf(sql, USER_WIN, id);
-
-        bool ret = mysql_util::mysql_exec(_mysql, sql);
+        bool ret = update_by_id(STMT_USER_WIN, USER_WIN, id);
+        _cache.erase(id); // 失败时也可能已经写入，缓存一律作废
         if (ret == false)
         {
             DLOG("update win user information failed");
@@ -218,14 +285,67 @@ public:
         return true;
     }
 
+    // 在一个事务中写入一批对局结果，每条update语句更新多个用户，失败时回滚，整批都没有写入
+    // 语句中只有整数，直接拼接成文本；行数每次不同，不适合预处理
+    bool apply_results(const std::vector<user_result> &results)
+    {
+        mysql_guard conn = _pool.acquire();
+        if (!conn)
+        {
+            return false;
+        }
+        if (mysql_autocommit(conn.get(), false))
+        {
+            conn.check_error();
+            return false;
+        }
+        // 提交前标记为更新中，这期间从数据库读出的信息不放入缓存
+        for (auto &r : results)
+        {
+            _cache.begin_update(r.id);
+        }
+        bool ret = true;
+        for (size_t begin = 0; begin < results.size() && ret; begin += RESULT_ROWS_PER_UPDATE)
+        {
+            // update user u join (select 1 id,30 ds,1 dt,1 dw union all select ...) d on u.id=d.id set ...
+            std::string sql = "update user u join (";
+            size_t end = std::min(results.size(), begin + RESULT_ROWS_PER_UPDATE);
+            for (size_t i = begin; i < end; i++)
+            {
+                const user_result &r = results[i];
+                char row[128] = {0};
+                snprintf(row, sizeof(row), "%sselect %lu id,%d ds,%d dt,%d dw", i == begin ? "" : " union all ",
+                         r.id, (r.wins - r.losses) * SCORE_DELTA, r.wins + r.losses, r.wins);
+                sql += row;
+            }
+            sql += ") d on u.id=d.id set u.score=u.score+d.ds,u.total_count=u.total_count+d.dt,u.win_count=u.win_count+d.dw;";
+            ret = conn.exec(sql);
+        }
+        if (ret && mysql_commit(conn.get()) == false)
+        {
+            DLOG("apply %zu results success", results.size());
+        }
+        else
+        {
+            ret = false;
+            conn.check_error();
+            mysql_rollback(conn.get());
+            ELOG("apply %zu results failed : %s", results.size(), mysql_error(conn.get()));
+        }
+        // 提交成功时在缓存上加上变化，玩家下次匹配不需要查询数据库；失败时移除
+        for (auto &r : results)
+        {
+            _cache.end_update(r.id, ret, (int64_t)(r.wins - r.losses) * SCORE_DELTA, r.wins + r.losses, r.wins);
+        }
+        mysql_autocommit(conn.get(), true);
+        return ret;
+    }
+
     // 失败时，分数-30，总场数+1
     bool lose(const uint64_t &id)
     {
-#define USER_LOSE "update user set score=score-30,total_count=total_count+1 where id = %d;"
-        char sql[4096] = {0};
-        sprintf(sql, USER_LOSE, id);
-
-        bool ret = mysql_util::mysql_exec(_mysql, sql);
+        bool ret = update_by_id(STMT_USER_LOSE, USER_LOSE, id);
+        _cache.erase(id); // 失败时也可能已经写入，缓存一律作废
         if (ret == false)
         {
             DLOG("update lose user information failed");
@@ -234,4 +354,4 @@ public:
         DLOG("update lose user information success");
         return true;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,165 @@
+// 登录的数据库基准测试：比较拼接sql文本查询和预处理语句查询的登录QPS，两种做法都从同一个连接池借用连接
+// 用法：db_bench [--host H] [--user U] [--password P] [--db D] [--port N] [--threads T] [--seconds S]
+// 会先注册一个测试用户，结果输出为一行JSON
+#define LOG_STREAM stderr // 日志输出到标准错误，标准输出只有一行JSON，可以直接交给jq
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <jsoncpp/json/json.h>
+
+#include "db.hpp"
+
+#define DB_BENCH_THREADS 8   // 默认并发线程数
+#define DB_BENCH_SECONDS 5   // 每种做法默认运行的秒数
+#define DB_BENCH_USER "db_bench_user"
+#define DB_BENCH_PASSWORD "db_bench_password"
+
+// 命令行参数
+struct db_bench_option
+{
+    std::string host = "127.0.0.1";
+    std::string user = "root";
+    std::string password;
+    std::string db = "online_gobang";
+    int port = 3306;
+    int threads = DB_BENCH_THREADS;
+    int seconds = DB_BENCH_SECONDS;
+};
+
+// 原来的做法：sprintf拼接语句，服务器每次重新解析，结果用std::stol转换
+static bool text_login(mysql_pool &pool, Json::Value &user)
+{
+    char sql[4096] = {0};
+    sprintf(sql, "select id,score,total_count,win_count from user where username='%s' and password=SHA2('%s',512);",
+            user["username"].asCString(), user["password"].asCString());
+    mysql_guard conn = pool.acquire();
+    if (!conn || conn.exec(sql) == false)
+    {
+        return false;
+    }
+    MYSQL_RES *res = mysql_store_result(conn.get());
+    if (res == nullptr)
+    {
+        return false;
+    }
+    bool ret = false;
+    if (mysql_num_rows(res) == 1)
+    {
+        MYSQL_ROW row = mysql_fetch_row(res);
+        user["id"] = (Json::UInt64)std::stol(row[0]);
+        user["score"] = (Json::UInt64)std::stol(row[1]);
+        user["total_count"] = std::stoi(row[2]);
+        user["win_count"] = std::stoi(row[3]);
+        ret = true;
+    }
+    mysql_free_result(res);
+    return ret;
+}
+
+// threads个线程在seconds秒内反复登录，返回QPS和失败次数
+template <class LOGIN>
+static Json::Value run(const char *name, const db_bench_option &option, LOGIN login)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> done(0), failed(0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < option.threads; i++)
+    {
+        workers.emplace_back([&]() {
+            while (stop.load(std::memory_order_relaxed) == false)
+            {
+                Json::Value user;
+                user["username"] = DB_BENCH_USER;
+                user["password"] = DB_BENCH_PASSWORD;
+                if (login(user))
+                {
+                    done.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(option.seconds));
+    stop = true;
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Json::Value result;
+    result["name"] = name;
+    result["logins"] = (Json::UInt64)done.load();
+    result["failed"] = (Json::UInt64)failed.load();
+    result["qps"] = done.load() / seconds;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    db_bench_option option;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "missing value: " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--host")
+            option.host = argv[++i];
+        else if (arg == "--user")
+            option.user = argv[++i];
+        else if (arg == "--password")
+            option.password = argv[++i];
+        else if (arg == "--db")
+            option.db = argv[++i];
+        else if (arg == "--port")
+            option.port = atoi(argv[++i]);
+        else if (arg == "--threads")
+            option.threads = atoi(argv[++i]);
+        else if (arg == "--seconds")
+            option.seconds = atoi(argv[++i]);
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (option.threads <= 0)
+    {
+        option.threads = DB_BENCH_THREADS;
+    }
+    if (option.seconds <= 0)
+    {
+        option.seconds = DB_BENCH_SECONDS;
+    }
+
+    // 连接数与线程数相同，比较的是语句本身的开销而不是等待连接的时间
+    user_table table(option.host, option.user, option.password, option.db, option.port, option.threads);
+    Json::Value bench_user;
+    bench_user["username"] = DB_BENCH_USER;
+    bench_user["password"] = DB_BENCH_PASSWORD;
+    table.insert(bench_user); // 测试用户已经存在时插入失败，不影响测试
+
+    Json::Value report;
+    report["threads"] = option.threads;
+    report["seconds"] = option.seconds;
+    report["text"] = run("text", option, [&](Json::Value &user) { return text_login(table.pool(), user); });
+    report["prepared"] = run("prepared", option, [&](Json::Value &user) { return table.login(user); });
+    double text_qps = report["text"]["qps"].asDouble();
+    report["speedup"] = text_qps > 0 ? report["prepared"]["qps"].asDouble() / text_qps : 0.0;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    std::cout << Json::writeString(builder, report) << std::endl;
+    return 0;
+}
@@ -0,0 +1,718 @@
+// 五子棋AI引擎模块，为机器人座位计算下一步棋
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <algorithm>
+
+#include "board.hpp"
+#include "pattern.hpp"
+#include "ttable.hpp"
+#include "cache.hpp"
+#include "threat.hpp"
+
+#define SCORE_FIVE 10000000     // 五子连珠的分数，实际返回时减去步数，越快获胜分数越高
+#define SCORE_INF 100000000     // 搜索窗口的无穷大
+#define SCORE_WIN_SOON 500000   // 静态估值能看出几步内必胜时的分数
+#define SEARCH_MAX_DEPTH 20     // 迭代加深的最大深度
+#define SEARCH_MAX_MOVES 12     // 每个节点最多展开的候选点数
+#define SEARCH_CHECK_NODES 1023 // 每搜索1024个节点检查一次是否超时
+#define SEARCH_THREAD_LIMIT 8   // 全局搜索线程上限(含主线程)，所有房间共享，给匹配线程和asio线程留出CPU
+#define BOT_THREADS 4           // 机器人线程数，每个机器人线程搜索时是主线程
+#define SEARCH_THREAT_NODES 20000 // 搜索前算杀的节点数上限
+
+static_assert(BOT_THREADS <= SEARCH_THREAD_LIMIT, "机器人线程数不能超过全局搜索线程上限");
+
+// 机器人难度
+enum bot_level
+{
+    BOT_EASY = 0,
+    BOT_NORMAL,
+    BOT_HARD,
+    BOT_LEVEL_COUNT
+};
+
+// 每个难度的搜索参数
+struct level_config
+{
+    int time_ms;   // 每步棋的思考时间，0表示不限时间，只按最大深度搜索
+    int max_depth; // 最大搜索深度
+    int threads;   // 搜索线程数(含主线程)，大于1时使用lazy-SMP并行搜索
+};
+
+static const level_config LEVEL_CONFIG[BOT_LEVEL_COUNT] = {
+    {300, 4, 1},   // 简单
+    {1000, 8, 2},  // 普通
+    {3000, 20, 4}, // 困难
+};
+
+// 全局辅助搜索线程池，所有机器人共享，线程常驻，等待主线程分配搜索任务
+// 每个机器人线程搜索时自己就是主线程，占一个名额，池中只有其余的 SEARCH_THREAD_LIMIT - BOT_THREADS 个线程
+// 空闲线程不够时退化为少开线程甚至单线程搜索，同时搜索的线程总数不会超过上限
+class search_pool
+{
+private:
+    std::deque<std::function<void()>> _tasks; // 已经分配了线程、等待执行的任务
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::vector<std::thread> _threads;
+    int _idle; // 没有被申请的线程数
+    bool _stop;
+
+    search_pool(const int thread_count)
+        : _idle(thread_count), _stop(false)
+    {
+        for (int i = 0; i < thread_count; i++)
+        {
+            _threads.push_back(std::thread(&search_pool::handler_task, this));
+        }
+    }
+
+    // 线程入口，不断取出任务执行，执行完归还名额
+    void handler_task()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (_tasks.empty() && _stop == false)
+                {
+                    _cond.wait(lock);
+                }
+                if (_tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idle++;
+        }
+        return;
+    }
+
+public:
+    ~search_pool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+            _cond.notify_all();
+        }
+        for (auto &t : _threads)
+        {
+            t.join();
+        }
+    }
+
+    static search_pool &instance()
+    {
+        static search_pool pool(SEARCH_THREAD_LIMIT - BOT_THREADS);
+        return pool;
+    }
+
+    // 申请最多want个辅助线程，返回实际申请到的个数，每个名额之后用run交给一个任务
+    int acquire(const int want)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        int take = std::max(0, std::min(want, _idle));
+        _idle -= take;
+        return take;
+    }
+
+    // 把任务交给一个已经申请到的线程执行
+    void run(const std::function<void()> &task)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _tasks.push_back(task);
+        _cond.notify_one();
+        return;
+    }
+
+    // 获取当前空闲的辅助线程数
+    int idle()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _idle;
+    }
+};
+
+// 候选走法
+struct chess_move
+{
+    int row;
+    int col;
+    int score; // 用于走法排序的启发分
+};
+
+// 搜索结果
+struct search_result
+{
+    int row = -1;           // 最佳落子位置，棋盘已满时为-1
+    int col = -1;
+    int score = 0;          // 站在落子方角度的分数
+    int depth = 0;          // 完整搜索完的深度
+    uint64_t nodes = 0;     // 搜索的节点数
+    uint64_t tt_probes = 0; // 查询置换表的次数
+    uint64_t tt_hits = 0;   // 置换表命中的次数
+};
+
+// 候选走法的生成结果
+enum gen_status
+{
+    GEN_NORMAL = 0, // 普通候选点
+    GEN_WIN,        // 存在直接成五的点，只返回这一个点
+    GEN_BLOCK       // 对方下一步能成五，只返回需要堵的点
+};
+
+// 搜索引擎：对棋盘副本做迭代加深的PVS(主变例)alpha-beta搜索
+// 每条线的棋型缓存在_shape中，落子后只对经过该点的四条线查棋型表
+// 多线程时采用lazy-SMP：每个辅助线程拷贝一份引擎各自搜索，只通过置换表共享结果
+class gobang_engine
+{
+private:
+    bit_board _board;                        // 搜索用的棋盘副本
+    uint8_t _shape[2][DIR_COUNT][BOARD_DIAG]; // 每条线上两种颜色各自最强的棋型
+    int _shape_count[2][SHAPE_COUNT];        // 两种颜色每种棋型的条数
+    int _total[2];                           // 两种颜色的估值总和
+    std::vector<std::vector<chess_move>> _ply_moves; // 每层的候选走法，避免搜索中分配内存
+    uint64_t _nodes;                         // 已搜索的节点数
+    uint64_t _tt_probes;                     // 查询置换表的次数
+    uint64_t _tt_hits;                       // 置换表命中的次数
+    int64_t _depth_us[SEARCH_MAX_DEPTH + 1]; // 主线程搜完每一层时距搜索开始的微秒数，-1表示没有搜完
+    std::chrono::steady_clock::time_point _start; // 本次搜索的开始时间
+    std::atomic<bool> *_stop;                // 是否停止搜索，所有搜索线程共享
+    transposition_table *_tt;                // 置换表，主线程所在线程的置换表，所有搜索线程共享
+    std::chrono::steady_clock::time_point _deadline; // 本次搜索的截止时间
+
+public:
+    gobang_engine(const bit_board &board)
+        : _board(board), _ply_moves(SEARCH_MAX_DEPTH + 2), _nodes(0), _tt_probes(0), _tt_hits(0),
+          _stop(nullptr), _tt(nullptr)
+    {
+        _total[0] = _total[1] = 0;
+        for (int d = 0; d <= SEARCH_MAX_DEPTH; d++)
+        {
+            _depth_us[d] = -1;
+        }
+        for (int s = 0; s < SHAPE_COUNT; s++)
+        {
+            _shape_count[0][s] = _shape_count[1][s] = 0;
+        }
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            for (int i = 0; i < bit_board::line_count((board_dir)d); i++)
+            {
+                _shape[0][d][i] = _shape[1][d][i] = SHAPE_NONE;
+                _shape_count[0][SHAPE_NONE]++;
+                _shape_count[1][SHAPE_NONE]++;
+                update_line((board_dir)d, i);
+            }
+        }
+        for (auto &moves : _ply_moves)
+        {
+            moves.reserve(BOARD_ROW * BOARD_COL);
+        }
+    }
+
+    // 为chess_color一方搜索下一步棋，按难度配置的思考时间、深度和线程数搜索
+    search_result search(const int chess_color, const level_config &config)
+    {
+        std::atomic<bool> stop(false);
+        _stop = &stop;
+        _tt = &thread_table();
+        _tt->new_search();
+        _start = std::chrono::steady_clock::now();
+        _deadline = config.time_ms > 0 ? _start + std::chrono::milliseconds(config.time_ms)
+                                       : std::chrono::steady_clock::time_point::max();
+        _nodes = _tt_probes = _tt_hits = 0;
+        for (int d = 0; d <= SEARCH_MAX_DEPTH; d++)
+        {
+            _depth_us[d] = -1;
+        }
+        search_result result;
+
+        std::vector<chess_move> root;
+        gen_status status = gen_moves(chess_color, root);
+        if (root.empty())
+        {
+            return result;
+        }
+        result.row = root[0].row;
+        result.col = root[0].col;
+        if (status == GEN_WIN || root.size() == 1) // 直接成五或者只有一个点可走，不需要搜索
+        {
+            result.score = status == GEN_WIN ? SCORE_FIVE : 0;
+            return result;
+        }
+
+        // 先算杀：能连续冲四取胜时直接走杀法的第一步，不需要搜索
+        threat_solver solver(_board, SEARCH_THREAT_NODES);
+        threat_result threat = solver.vcf(chess_color);
+        if (threat.win)
+        {
+            result.row = threat.row;
+            result.col = threat.col;
+            result.score = SCORE_FIVE - (2 * threat.depth - 1);
+            result.depth = threat.depth * 2 - 1;
+            result.nodes = threat.nodes;
+            return result;
+        }
+
+        // 先查局面缓存：其他房间已经搜索到足够深度或者已经算出胜负时直接使用，否则用缓存的走法排序
+        position_info cached;
+        if (position_cache::instance().lookup(_board.key(), cached) && _board.empty(cached.row, cached.col))
+        {
+            if (cached.depth >= config.max_depth || std::abs(cached.score) >= SCORE_FIVE - SEARCH_MAX_DEPTH)
+            {
+                result.row = cached.row;
+                result.col = cached.col;
+                result.score = cached.score;
+                result.depth = cached.depth;
+                return result;
+            }
+            for (size_t i = 1; i < root.size(); i++)
+            {
+                if (root[i].row == cached.row && root[i].col == cached.col)
+                {
+                    std::rotate(root.begin(), root.begin() + i, root.begin() + i + 1);
+                    break;
+                }
+            }
+        }
+
+        // 把辅助线程池中申请到的线程分给辅助引擎，每个线程从不同的根节点走法和深度开始，打散搜索顺序
+        search_pool &pool = search_pool::instance();
+        int helper_count = pool.acquire(config.threads - 1);
+        std::vector<gobang_engine> helpers(helper_count, *this);
+        std::mutex done_mutex;
+        std::condition_variable done_cond;
+        int running = helper_count; // 还没有结束的辅助引擎数
+        for (int i = 0; i < helper_count; i++)
+        {
+            std::vector<chess_move> order = root;
+            std::rotate(order.begin(), order.begin() + (i + 1) % order.size(), order.end());
+            gobang_engine *helper = &helpers[i];
+            int start_depth = 1 + (i + 1) % 2;
+            pool.run([=, &done_mutex, &done_cond, &running]()
+                     {
+                         helper->iterate(chess_color, order, config.max_depth, start_depth);
+                         // 持有锁通知，主线程被唤醒时这里已经不再访问它栈上的变量
+                         std::unique_lock<std::mutex> lock(done_mutex);
+                         if (--running == 0)
+                         {
+                             done_cond.notify_one();
+                         } });
+        }
+
+        // 主线程的结果作为最终结果，主线程结束后通知辅助线程停止，等它们都结束后再汇总
+        result = iterate(chess_color, root, config.max_depth, 1);
+        stop.store(true);
+        {
+            std::unique_lock<std::mutex> lock(done_mutex);
+            while (running > 0)
+            {
+                done_cond.wait(lock);
+            }
+        }
+        for (int i = 0; i < helper_count; i++)
+        {
+            result.nodes += helpers[i]._nodes;
+            result.tt_probes += helpers[i]._tt_probes;
+            result.tt_hits += helpers[i]._tt_hits;
+        }
+        if (result.depth > 0)
+        {
+            position_info info = {result.row, result.col, result.score, result.depth};
+            position_cache::instance().store(_board.key(), info);
+        }
+        return result;
+    }
+
+    // 获取最近一次搜索中主线程搜完depth层所用的微秒数，没有搜完返回-1
+    int64_t depth_time(const int depth) const
+    {
+        return depth >= 0 && depth <= SEARCH_MAX_DEPTH ? _depth_us[depth] : -1;
+    }
+
+    // 站在chess_color一方的局面估值，轮到chess_color下棋
+    int evaluate(const int chess_color) const
+    {
+        const int *own = _shape_count[chess_color - 1];
+        const int *opp = _shape_count[2 - chess_color];
+        if (own[SHAPE_FOUR] + own[SHAPE_OPEN_FOUR] > 0) // 己方有四，下一步成五
+        {
+            return SCORE_WIN_SOON;
+        }
+        if (opp[SHAPE_OPEN_FOUR] > 0 || opp[SHAPE_FOUR] > 1) // 对方有活四或者双四，堵不住
+        {
+            return -SCORE_WIN_SOON;
+        }
+        if (own[SHAPE_OPEN_THREE] > 0 && opp[SHAPE_FOUR] == 0) // 己方活三先走成活四
+        {
+            return SCORE_WIN_SOON / 2;
+        }
+        return _total[chess_color - 1] - _total[2 - chess_color];
+    }
+
+private:
+    // 当前线程的置换表，每个机器人线程第一次搜索时创建，之后每次搜索重复使用
+    static transposition_table &thread_table()
+    {
+        static_assert(BOARD_ROW * BOARD_COL < 0xFFF, "置换表中最佳走法只有12位");
+        thread_local transposition_table tt;
+        return tt;
+    }
+
+    // 对根节点做迭代加深搜索，start_depth为起始深度，辅助线程从不同深度开始
+    search_result iterate(const int chess_color, std::vector<chess_move> root, const int max_depth, const int start_depth)
+    {
+        search_result result;
+        result.row = root[0].row;
+        result.col = root[0].col;
+        int opp_color = 3 - chess_color;
+        for (int depth = start_depth; depth <= max_depth && depth <= SEARCH_MAX_DEPTH; depth++)
+        {
+            int alpha = -SCORE_INF;
+            int best = -SCORE_INF;
+            size_t best_index = 0;
+            for (size_t i = 0; i < root.size(); i++)
+            {
+                const chess_move &m = root[i];
+                do_move(m.row, m.col, chess_color);
+                int score = 0;
+                if (i == 0)
+                {
+                    score = -pvs(depth - 1, -SCORE_INF, -alpha, opp_color, 1);
+                }
+                else
+                {
+                    score = -pvs(depth - 1, -alpha - 1, -alpha, opp_color, 1);
+                    if (score > alpha)
+                    {
+                        score = -pvs(depth - 1, -SCORE_INF, -alpha, opp_color, 1);
+                    }
+                }
+                undo_move(m.row, m.col, chess_color);
+                if (stopped())
+                {
+                    break;
+                }
+                if (score > best)
+                {
+                    best = score;
+                    best_index = i;
+                    alpha = std::max(alpha, score);
+                }
+            }
+            if (stopped()) // 没搜索完的这一层结果不可信，使用上一层的结果
+            {
+                break;
+            }
+            // 把最佳走法移到最前面，下一层优先搜索
+            std::rotate(root.begin(), root.begin() + best_index, root.begin() + best_index + 1);
+            result.row = root[0].row;
+            result.col = root[0].col;
+            result.score = best;
+            result.depth = depth;
+            _depth_us[depth] = std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - _start).count();
+            if (best >= SCORE_FIVE - SEARCH_MAX_DEPTH || best <= -SCORE_FIVE + SEARCH_MAX_DEPTH)
+            {
+                break; // 已经找到必胜或者必败，不需要继续加深
+            }
+        }
+        result.nodes = _nodes;
+        result.tt_probes = _tt_probes;
+        result.tt_hits = _tt_hits;
+        return result;
+    }
+
+    // 是否需要停止搜索
+    bool stopped() const
+    {
+        return _stop->load(std::memory_order_relaxed);
+    }
+
+    // 置换表中的必胜分数与步数有关，存入时换算成相对当前节点的分数，取出时再换算回来
+    static int score_to_tt(const int score, const int ply)
+    {
+        if (score >= SCORE_FIVE - SEARCH_MAX_DEPTH * 2)
+        {
+            return score + ply;
+        }
+        if (score <= -SCORE_FIVE + SEARCH_MAX_DEPTH * 2)
+        {
+            return score - ply;
+        }
+        return score;
+    }
+
+    static int score_from_tt(const int score, const int ply)
+    {
+        if (score >= SCORE_FIVE - SEARCH_MAX_DEPTH * 2)
+        {
+            return score - ply;
+        }
+        if (score <= -SCORE_FIVE + SEARCH_MAX_DEPTH * 2)
+        {
+            return score + ply;
+        }
+        return score;
+    }
+
+    // 计算一条线对某一方的估值，即这条线上最强棋型的分数
+    static int line_value(const uint32_t own, const uint32_t opp, const uint32_t mask)
+    {
+        return SHAPE_SCORE[line_shape(own, opp, mask)];
+    }
+
+    // 重新计算一条线上双方的棋型，并更新棋型计数和估值总和
+    void update_line(const board_dir dir, const int index)
+    {
+        uint32_t mask = bit_board::line_mask(dir, index);
+        uint32_t white = _board.line_bits(WHITE_CHESS, dir, index);
+        uint32_t black = _board.line_bits(BLACK_CHESS, dir, index);
+        int shape[2] = {line_shape(white, black, mask), line_shape(black, white, mask)};
+        for (int c = 0; c < 2; c++)
+        {
+            int old = _shape[c][dir][index];
+            _shape_count[c][old]--;
+            _shape_count[c][shape[c]]++;
+            _total[c] += SHAPE_SCORE[shape[c]] - SHAPE_SCORE[old];
+            _shape[c][dir][index] = (uint8_t)shape[c];
+        }
+        return;
+    }
+
+    // 落子并更新经过该点的四条线
+    void do_move(const int row, const int col, const int chess_color)
+    {
+        _board.put(row, col, chess_color);
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            update_line((board_dir)d, bit_board::line_index(row, col, (board_dir)d));
+        }
+        return;
+    }
+
+    // 撤销落子
+    void undo_move(const int row, const int col, const int chess_color)
+    {
+        _board.remove(row, col, chess_color);
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            update_line((board_dir)d, bit_board::line_index(row, col, (board_dir)d));
+        }
+        return;
+    }
+
+    // 估计在(row, col)落子后，经过该点的四条线上own一方估值的增量，five记录是否恰好成五
+    int move_gain(const int row, const int col, const int own_color, bool &five) const
+    {
+        int opp_color = 3 - own_color;
+        int gain = 0;
+        five = false;
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            board_dir dir = (board_dir)d;
+            int index = bit_board::line_index(row, col, dir);
+            int pos = bit_board::line_pos(row, col, dir);
+            uint32_t mask = bit_board::line_mask(dir, index);
+            uint32_t own = _board.line_bits(own_color, dir, index) | (1u << pos);
+            uint32_t opp = _board.line_bits(opp_color, dir, index);
+            gain += line_value(own, opp, mask) - SHAPE_SCORE[_shape[own_color - 1][d][index]];
+            gain += SHAPE_SCORE[_shape[opp_color - 1][d][index]] - line_value(opp, own, mask);
+            five |= bit_board::run_at(own, pos) == 5;
+        }
+        return gain;
+    }
+
+    // 生成候选走法：只考虑已有棋子周围两格内的空位，按进攻和防守价值排序
+    gen_status gen_moves(const int chess_color, std::vector<chess_move> &moves) const
+    {
+        moves.clear();
+        if (_board.count() == 0)
+        {
+            moves.push_back(chess_move{BOARD_ROW / 2, BOARD_COL / 2, 0});
+            return GEN_NORMAL;
+        }
+
+        uint32_t occupied[BOARD_ROW];
+        for (int r = 0; r < BOARD_ROW; r++)
+        {
+            occupied[r] = _board.line_bits(WHITE_CHESS, DIR_ROW, r) | _board.line_bits(BLACK_CHESS, DIR_ROW, r);
+        }
+
+        int opp_color = 3 - chess_color;
+        int block_count = 0;
+        const uint32_t full = (1u << BOARD_COL) - 1;
+        for (int r = 0; r < BOARD_ROW; r++)
+        {
+            // 把上下两行内的棋子向左右各扩散两格，得到这一行靠近棋子的空位
+            uint32_t near = 0;
+            for (int rr = std::max(0, r - 2); rr <= std::min(BOARD_ROW - 1, r + 2); rr++)
+            {
+                uint32_t o = occupied[rr];
+                near |= o | (o << 1) | (o << 2) | (o >> 1) | (o >> 2);
+            }
+            near &= full & ~occupied[r];
+            while (near != 0)
+            {
+                int c = __builtin_ctz(near);
+                near &= near - 1;
+                bool own_five = false, opp_five = false;
+                int attack = move_gain(r, c, chess_color, own_five);
+                int defend = move_gain(r, c, opp_color, opp_five);
+                if (own_five)
+                {
+                    moves.clear();
+                    moves.push_back(chess_move{r, c, SCORE_FIVE});
+                    return GEN_WIN;
+                }
+                chess_move m = {r, c, attack + defend};
+                if (opp_five) // 对方在这里能成五，必须堵，排在最前面
+                {
+                    m.score = SCORE_FIVE;
+                    block_count++;
+                }
+                moves.push_back(m);
+            }
+        }
+
+        std::sort(moves.begin(), moves.end(), [](const chess_move &a, const chess_move &b)
+                  { return a.score > b.score; });
+        if (block_count > 0)
+        {
+            moves.resize(block_count);
+            return GEN_BLOCK;
+        }
+        if (moves.size() > SEARCH_MAX_MOVES)
+        {
+            moves.resize(SEARCH_MAX_MOVES);
+        }
+        return GEN_NORMAL;
+    }
+
+    // 主变例搜索，返回站在chess_color一方角度的分数
+    int pvs(const int depth, int alpha, int beta, const int chess_color, const int ply)
+    {
+        if ((++_nodes & SEARCH_CHECK_NODES) == 0 && std::chrono::steady_clock::now() >= _deadline)
+        {
+            _stop->store(true, std::memory_order_relaxed);
+        }
+        if (stopped())
+        {
+            return 0;
+        }
+        if (depth <= 0)
+        {
+            return evaluate(chess_color);
+        }
+
+        // 查置换表，深度足够时直接使用，否则只用其中的最佳走法排序
+        int tt_score = 0, tt_depth = 0, tt_move = -1;
+        tt_flag flag = TT_EXACT;
+        _tt_probes++;
+        bool tt_found = _tt->probe(_board.key(), tt_score, tt_depth, flag, tt_move);
+        _tt_hits += tt_found;
+        if (tt_found && tt_depth >= depth)
+        {
+            tt_score = score_from_tt(tt_score, ply);
+            if (flag == TT_EXACT)
+            {
+                return tt_score;
+            }
+            if (flag == TT_LOWER)
+            {
+                alpha = std::max(alpha, tt_score);
+            }
+            else
+            {
+                beta = std::min(beta, tt_score);
+            }
+            if (alpha >= beta)
+            {
+                return tt_score;
+            }
+        }
+
+        std::vector<chess_move> &moves = _ply_moves[ply];
+        if (gen_moves(chess_color, moves) == GEN_WIN)
+        {
+            return SCORE_FIVE - ply;
+        }
+        if (moves.empty()) // 棋盘下满，和棋
+        {
+            return 0;
+        }
+        if (tt_move >= 0) // 置换表中的最佳走法放到最前面
+        {
+            for (size_t i = 1; i < moves.size(); i++)
+            {
+                if (moves[i].row * BOARD_COL + moves[i].col == tt_move)
+                {
+                    std::rotate(moves.begin(), moves.begin() + i, moves.begin() + i + 1);
+                    break;
+                }
+            }
+        }
+
+        int alpha_orig = alpha;
+        int opp_color = 3 - chess_color;
+        int best = -SCORE_INF;
+        int best_move = -1;
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            int row = moves[i].row, col = moves[i].col;
+            do_move(row, col, chess_color);
+            int score = 0;
+            if (i == 0)
+            {
+                score = -pvs(depth - 1, -beta, -alpha, opp_color, ply + 1);
+            }
+            else
+            {
+                // 先用空窗口验证，失败时再用完整窗口重新搜索
+                score = -pvs(depth - 1, -alpha - 1, -alpha, opp_color, ply + 1);
+                if (score > alpha && score < beta)
+                {
+                    score = -pvs(depth - 1, -beta, -alpha, opp_color, ply + 1);
+                }
+            }
+            undo_move(row, col, chess_color);
+            if (stopped())
+            {
+                return 0;
+            }
+            if (score > best)
+            {
+                best = score;
+                best_move = row * BOARD_COL + col;
+                if (score > alpha)
+                {
+                    alpha = score;
+                    if (alpha >= beta)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        tt_flag store_flag = best <= alpha_orig ? TT_UPPER : (best >= beta ? TT_LOWER : TT_EXACT);
+        _tt->store(_board.key(), score_to_tt(best, ply), depth, store_flag, best_move);
+        return best;
+    }
+};
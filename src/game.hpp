@@ -0,0 +1,280 @@
+// 对局模块，棋盘大小和胜负规则都是模板参数，每种变体编译出各自的落子和胜负判断
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "board.hpp"
+#include "engine.hpp"
+#include "renju.hpp"
+
+// 无禁手规则：五子及以上连珠获胜，白方先手，每方每回合一子
+struct freestyle_rule
+{
+    static constexpr int WIN = 5;
+    static constexpr bool FORBIDDEN = false; // 是否有禁手
+
+    static constexpr bool is_win(const int run, const int)
+    {
+        return run >= WIN;
+    }
+
+    static constexpr int color_to_move(const int count)
+    {
+        return count % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+    }
+
+    static const char *win_reason()
+    {
+        return "五星连珠，恭喜你获胜了！！！";
+    }
+
+    // 没有禁手的规则不会调用下面两个函数
+    template <class BOARD>
+    static int forbidden(BOARD &, const int, const int, const int)
+    {
+        return 0;
+    }
+
+    static const char *forbid_reason(const int)
+    {
+        return "";
+    }
+};
+
+// 标准规则：恰好五子连珠获胜，长连不算
+struct standard_rule : public freestyle_rule
+{
+    static constexpr bool is_win(const int run, const int)
+    {
+        return run == WIN;
+    }
+};
+
+// 连珠规则：黑方先手，黑方三三、四四、长连为禁手，只有恰好五子才算获胜；白方五子及以上获胜
+struct renju_rule : public freestyle_rule
+{
+    static constexpr bool FORBIDDEN = true;
+
+    static constexpr bool is_win(const int run, const int chess_color)
+    {
+        return chess_color == BLACK_CHESS ? run == WIN : run >= WIN;
+    }
+
+    static constexpr int color_to_move(const int count)
+    {
+        return count % 2 == 0 ? BLACK_CHESS : WHITE_CHESS;
+    }
+
+    // 只检查黑方，返回renju_forbid
+    static int forbidden(bit_board &board, const int row, const int col, const int chess_color)
+    {
+        return chess_color == BLACK_CHESS ? renju_detector::check(board, row, col) : RENJU_NONE;
+    }
+
+    static const char *forbid_reason(const int forbid)
+    {
+        return RENJU_REASON[forbid];
+    }
+};
+
+// 六子棋：六子及以上连珠获胜，先手第一回合下一子，之后双方每回合各下两子
+struct connect6_rule : public freestyle_rule
+{
+    static constexpr int WIN = 6;
+
+    static constexpr bool is_win(const int run, const int)
+    {
+        return run >= WIN;
+    }
+
+    // 第n子(从0开始)属于第(n+1)/2回合，偶数回合是先手
+    static constexpr int color_to_move(const int count)
+    {
+        return ((count + 1) / 2) % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+    }
+
+    static const char *win_reason()
+    {
+        return "六子连珠，恭喜你获胜了！！！";
+    }
+};
+
+// 房间支持的对局变体
+enum game_variant
+{
+    VARIANT_STANDARD_15 = 0, // 15路标准规则，默认变体，机器人只支持这一种
+    VARIANT_FREESTYLE_15,    // 15路无禁手
+    VARIANT_FREESTYLE_19,    // 19路无禁手
+    VARIANT_CONNECT6_19,     // 19路六子棋
+    VARIANT_RENJU_15,        // 15路连珠，黑方有禁手
+    VARIANT_COUNT
+};
+
+// 变体名称，与前端约定
+static const char *VARIANT_NAME[VARIANT_COUNT] = {"standard15", "freestyle15", "freestyle19", "connect6", "renju"};
+
+// 按名称查找变体，找不到返回false
+inline bool variant_from_name(const std::string &name, game_variant &variant)
+{
+    for (int i = 0; i < VARIANT_COUNT; i++)
+    {
+        if (name == VARIANT_NAME[i])
+        {
+            variant = (game_variant)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 落子结果
+enum put_result
+{
+    PUT_OK = 0,   // 落子成功，未分胜负
+    PUT_WIN,      // 落子成功并获胜
+    PUT_FORBIDDEN // 禁手，没有落子
+};
+
+// 机器人引擎：只有15路标准规则有对应的搜索实现，其余组合不支持机器人
+template <int SIZE, class RULE>
+struct bot_engine
+{
+    static constexpr bool SUPPORTED = false;
+
+    static search_result search(const basic_board<SIZE> &, const int, const level_config &)
+    {
+        return search_result(); // 不支持的变体没有落子位置，row和col为-1
+    }
+};
+
+template <>
+struct bot_engine<BOARD_ROW, standard_rule>
+{
+    static constexpr bool SUPPORTED = true;
+
+    static search_result search(const bit_board &board, const int chess_color, const level_config &config)
+    {
+        gobang_engine engine(board);
+        return engine.search(chess_color, config);
+    }
+};
+
+// 对局的公共接口，房间只通过这个接口操作棋盘，每次落子只有一次虚函数调用
+class game_base
+{
+public:
+    virtual ~game_base() {}
+
+    virtual game_variant variant() const = 0;                  // 对局变体
+    virtual int size() const = 0;                              // 棋盘边长
+    virtual bool in_board(const int row, const int col) const = 0;
+    virtual bool empty(const int row, const int col) const = 0;
+    virtual int next_color() const = 0;                        // 下一步该哪一方下棋
+    virtual put_result put(const int row, const int col, const int chess_color) = 0; // 落子并判断胜负和禁手
+    virtual const char *win_reason() const = 0;
+    virtual const char *forbid_reason() const = 0;             // 最近一次禁手的原因
+    virtual bool bot_supported() const = 0;
+    virtual std::unique_ptr<game_base> clone() const = 0;      // 复制一份局面，交给机器人线程搜索
+    virtual search_result search(const int chess_color, const level_config &config) const = 0;
+};
+
+// 某种棋盘大小和规则的对局，所有判断都在编译期确定，没有针对其他变体的分支
+template <int SIZE, class RULE, game_variant VARIANT>
+class game : public game_base
+{
+private:
+    basic_board<SIZE> _board;       // 棋盘
+    basic_run_tracker<SIZE> _runs; // 棋盘上每段连子的长度，用于O(1)判断胜负
+    int _forbid;                   // 最近一次禁手的类型
+
+public:
+    game()
+        : _forbid(0)
+    {
+    }
+
+    game_variant variant() const override
+    {
+        return VARIANT;
+    }
+
+    int size() const override
+    {
+        return SIZE;
+    }
+
+    bool in_board(const int row, const int col) const override
+    {
+        return basic_board<SIZE>::in_board(row, col);
+    }
+
+    bool empty(const int row, const int col) const override
+    {
+        return _board.empty(row, col);
+    }
+
+    int next_color() const override
+    {
+        return RULE::color_to_move(_board.count());
+    }
+
+    put_result put(const int row, const int col, const int chess_color) override
+    {
+        // RULE::FORBIDDEN是编译期常量，没有禁手的变体这里的判断会被整体去掉
+        if (RULE::FORBIDDEN && (_forbid = RULE::forbidden(_board, row, col, chess_color)) != 0)
+        {
+            return PUT_FORBIDDEN;
+        }
+        _board.put(row, col, chess_color);
+        _runs.put(_board, row, col, chess_color);
+        bool win = RULE::is_win(_runs.run(row, col, DIR_COL), chess_color) |
+                   RULE::is_win(_runs.run(row, col, DIR_ROW), chess_color) |
+                   RULE::is_win(_runs.run(row, col, DIR_DIAG), chess_color) |
+                   RULE::is_win(_runs.run(row, col, DIR_ANTI), chess_color);
+        return win ? PUT_WIN : PUT_OK;
+    }
+
+    const char *win_reason() const override
+    {
+        return RULE::win_reason();
+    }
+
+    const char *forbid_reason() const override
+    {
+        return RULE::forbid_reason(_forbid);
+    }
+
+    bool bot_supported() const override
+    {
+        return bot_engine<SIZE, RULE>::SUPPORTED;
+    }
+
+    std::unique_ptr<game_base> clone() const override
+    {
+        return std::unique_ptr<game_base>(new game(*this));
+    }
+
+    search_result search(const int chess_color, const level_config &config) const override
+    {
+        return bot_engine<SIZE, RULE>::search(_board, chess_color, config);
+    }
+};
+
+// 按变体创建对局
+inline std::unique_ptr<game_base> create_game(const game_variant variant)
+{
+    switch (variant)
+    {
+    case VARIANT_FREESTYLE_15:
+        return std::unique_ptr<game_base>(new game<15, freestyle_rule, VARIANT_FREESTYLE_15>());
+    case VARIANT_FREESTYLE_19:
+        return std::unique_ptr<game_base>(new game<19, freestyle_rule, VARIANT_FREESTYLE_19>());
+    case VARIANT_CONNECT6_19:
+        return std::unique_ptr<game_base>(new game<19, connect6_rule, VARIANT_CONNECT6_19>());
+    case VARIANT_RENJU_15:
+        return std::unique_ptr<game_base>(new game<15, renju_rule, VARIANT_RENJU_15>());
+    default:
+        return std::unique_ptr<game_base>(new game<15, standard_rule, VARIANT_STANDARD_15>());
+    }
+}
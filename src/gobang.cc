@@ -1,4 +1,6 @@
 #include <iostream>
+#include <chrono>
+#include <cstdlib>
 #include "log.hpp"
 #include "util.hpp"
 #include "db.hpp"
@@ -76,6 +78,134 @@ void test_read()
     std::cout << body << std::endl;
 }
 
+// 原先room::five()的逐格遍历写法，仅用于和run_tracker做性能对比
+int walk_five(int board[BOARD_ROW][BOARD_COL], int row, int col, int offset_row, int offset_col, int chess_color)
+{
+    int count = 1;
+    for (int r = row + offset_row, c = col + offset_col;
+         r >= 0 && r < BOARD_ROW && c >= 0 && c < BOARD_COL && board[r][c] == chess_color;
+         r += offset_row, c += offset_col)
+    {
+        count++;
+    }
+    for (int r = row - offset_row, c = col - offset_col;
+         r >= 0 && r < BOARD_ROW && c >= 0 && c < BOARD_COL && board[r][c] == chess_color;
+         r -= offset_row, c -= offset_col)
+    {
+        count++;
+    }
+    return count;
+}
+
+// 测试胜负判断：随机下满棋盘，对比逐格遍历five()和run_tracker的结果与耗时
+void test_check_win()
+{
+    const int games = 20000;
+    const int cells = BOARD_ROW * BOARD_COL;
+    std::vector<int> order(cells);
+    std::vector<std::vector<int>> all_games;
+    srand(1);
+    for (int g = 0; g < games; g++)
+    {
+        for (int i = 0; i < cells; i++)
+        {
+            order[i] = i;
+        }
+        for (int i = cells - 1; i > 0; i--)
+        {
+            std::swap(order[i], order[rand() % (i + 1)]);
+        }
+        all_games.push_back(order);
+    }
+
+    // 1.逐格遍历
+    long walk_wins = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &game : all_games)
+    {
+        int board[BOARD_ROW][BOARD_COL] = {{0}};
+        for (int i = 0; i < cells; i++)
+        {
+            int row = game[i] / BOARD_COL, col = game[i] % BOARD_COL;
+            int color = i % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+            board[row][col] = color;
+            if (walk_five(board, row, col, 1, 0, color) == 5 || walk_five(board, row, col, 0, 1, color) == 5 ||
+                walk_five(board, row, col, -1, -1, color) == 5 || walk_five(board, row, col, -1, 1, color) == 5)
+            {
+                walk_wins++;
+            }
+        }
+    }
+    auto walk_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // 2.增量连子长度，颜色从位棋盘读取，计时包含位棋盘的落子
+    long run_wins = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto &game : all_games)
+    {
+        bit_board board;
+        run_tracker runs;
+        for (int i = 0; i < cells; i++)
+        {
+            int row = game[i] / BOARD_COL, col = game[i] % BOARD_COL;
+            int color = i % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+            board.put(row, col, color);
+            runs.put(board, row, col, color);
+            if (runs.five(row, col))
+            {
+                run_wins++;
+            }
+        }
+    }
+    auto run_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    double moves = (double)games * cells;
+    std::cout << "five() walk   : " << walk_ns / moves << " ns/move, wins " << walk_wins << std::endl;
+    std::cout << "run_tracker   : " << run_ns / moves << " ns/move, wins " << run_wins << std::endl;
+}
+
+// 测试连珠禁手检测每步的耗时，随机对局中黑方的禁手点不落子，换下一个位置
+void test_renju()
+{
+    const int games = 20000;
+    const int cells = BOARD_ROW * BOARD_COL;
+    std::vector<int> order(cells);
+    srand(1);
+    long moves = 0, forbidden = 0, wins = 0;
+    long check_ns = 0;
+    for (int g = 0; g < games; g++)
+    {
+        for (int i = 0; i < cells; i++)
+        {
+            order[i] = i;
+        }
+        for (int i = cells - 1; i > 0; i--)
+        {
+            std::swap(order[i], order[rand() % (i + 1)]);
+        }
+        std::unique_ptr<game_base> renju = create_game(VARIANT_RENJU_15);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < cells; i++)
+        {
+            int row = order[i] / BOARD_COL, col = order[i] % BOARD_COL;
+            put_result put = renju->put(row, col, renju->next_color());
+            moves++;
+            if (put == PUT_FORBIDDEN)
+            {
+                forbidden++;
+            }
+            else if (put == PUT_WIN)
+            {
+                wins++;
+                break;
+            }
+        }
+        check_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::cout << "renju put     : " << (double)check_ns / moves << " ns/move, moves " << moves
+              << ", forbidden " << forbidden << ", wins " << wins << std::endl;
+}
+
 int main()
 {
     // test_log();
@@ -83,6 +213,8 @@ int main()
     // test_json();
     // test_split();
     // test_read();
+    // test_check_win();
+    // test_renju();
     gobang_server _server(HOST, USERNAME, PASSWORD, DBNAME);
     _server.start(3489);
 
@@ -0,0 +1,163 @@
+// http请求解析的基准测试：比较按std::string分割和按str_view解析cookie、查询串、路径时每个请求的内存申请次数和耗时
+// 用法：http_bench [--requests N]，结果输出为一行JSON
+#define LOG_STREAM stderr // 日志输出到标准错误，标准输出只有一行JSON，可以直接交给jq
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <jsoncpp/json/json.h>
+
+#include "str_view.hpp"
+
+#define HTTP_BENCH_REQUESTS 1000000 // 默认解析的请求数
+
+// 统计进程内operator new的调用次数
+static std::atomic<uint64_t> g_allocs(0);
+
+void *operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// 浏览器带的典型请求头
+static const std::string BENCH_COOKIE = "_ga=GA1.1.1234567890.1700000000; theme=dark; SSID=16777217; lang=zh-CN";
+static const std::string BENCH_URI = "/room/replay/42?uid=1001&step=17&view=full";
+
+// 原来的做法：先按";"分割，再对每一段按"="分割，值用std::stoull转换
+static bool legacy_cookie(const std::string &cookie_str, uint64_t &ssid)
+{
+    std::vector<std::string> cookie_arr;
+    string_util::split(cookie_str, "; ", cookie_arr);
+    for (auto &tmp : cookie_arr)
+    {
+        std::vector<std::string> ssd_arr;
+        size_t ret = string_util::split(tmp, "=", ssd_arr);
+        if (ret != 2)
+        {
+            continue;
+        }
+        if (ssd_arr[0] == "SSID")
+        {
+            ssid = std::stoull(ssd_arr[1]);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool legacy_uri(const std::string &uri, uint64_t &step)
+{
+    std::vector<std::string> parts;
+    string_util::split(uri, "?", parts);
+    std::vector<std::string> segments;
+    string_util::split(parts[0], "/", segments);
+    std::vector<std::string> pairs;
+    string_util::split(parts[1], "&", pairs);
+    for (auto &pair : pairs)
+    {
+        std::vector<std::string> kv;
+        if (string_util::split(pair, "=", kv) == 2 && kv[0] == "step")
+        {
+            step = std::stoull(kv[1]);
+            return segments.size() == 3;
+        }
+    }
+    return false;
+}
+
+static bool view_cookie(const std::string &cookie_str, uint64_t &ssid)
+{
+    str_view val;
+    return string_util::cookie_value(cookie_str, "SSID", val) && string_util::to_uint64(val, ssid);
+}
+
+static bool view_uri(const std::string &uri, uint64_t &step)
+{
+    str_view path = string_util::uri_path(uri), segment;
+    int segments = 0;
+    while (string_util::next_segment(path, segment))
+    {
+        segments++;
+    }
+    str_view val;
+    return string_util::query_value(string_util::uri_query(uri), "step", val) && string_util::to_uint64(val, step) &&
+           segments == 3;
+}
+
+// 每个请求解析一次cookie和一次uri，返回每个请求的申请次数和耗时
+template <class COOKIE, class URI>
+static Json::Value run(const char *name, const int requests, COOKIE cookie, URI uri)
+{
+    uint64_t checksum = 0;
+    uint64_t allocs = g_allocs.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; i++)
+    {
+        uint64_t ssid = 0, step = 0;
+        if (cookie(BENCH_COOKIE, ssid) && uri(BENCH_URI, step))
+        {
+            checksum += ssid + step;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocs = g_allocs.load() - allocs;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    Json::Value result;
+    result["name"] = name;
+    result["allocs_per_request"] = (double)allocs / requests;
+    result["ns_per_request"] = ns / requests;
+    result["checksum"] = (Json::UInt64)checksum; // 防止循环被优化掉，两种做法结果应当相同
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int requests = HTTP_BENCH_REQUESTS;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--requests" && i + 1 < argc)
+        {
+            requests = atoi(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (requests <= 0)
+    {
+        requests = HTTP_BENCH_REQUESTS;
+    }
+
+    Json::Value report;
+    report["requests"] = requests;
+    report["split"] = run("split", requests, legacy_cookie, legacy_uri);
+    report["str_view"] = run("str_view", requests, view_cookie, view_uri);
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    std::cout << Json::writeString(builder, report) << std::endl;
+    return 0;
+}
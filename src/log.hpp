@@ -10,6 +10,11 @@
 // 默认日志等级为信息类日志
 #define DEFAULT_LOG_LEVEL INF
 
+// 日志输出的流，默认为标准输出；基准测试程序在包含头文件前定义为stderr，标准输出只留给结果
+#ifndef LOG_STREAM
+#define LOG_STREAM stdout
+#endif
+
 // 日志宏函数
 // 需要输出            时间        文件名 第几行    日志信息
 // 例如      [2024-10-27 21:50:43 log.hpp:34][DEBUG] mysql init error
@@ -22,7 +27,7 @@
         struct tm *lt = localtime(&tp);                                                                   \
         char buffer[32];                                                                                  \
         size_t n = strftime(buffer, sizeof(buffer) - 1, "%Y-%m-%d %H:%M:%S", lt);                         \
-        fprintf(stdout, "[%s %s:%d][%s] " format "\n", buffer, __FILE__, __LINE__, LEVEL, ##__VA_ARGS__); \
+        fprintf(LOG_STREAM, "[%s %s:%d][%s] " format "\n", buffer, __FILE__, __LINE__, LEVEL, ##__VA_ARGS__); \
     } while (0)
 
 #define ILOG(format, ...) LOG(INF, format, ##__VA_ARGS__)
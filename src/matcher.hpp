@@ -2,10 +2,13 @@
 #pragma once
 
 #include <list>
+#include <chrono>
 #include <thread>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
+#include <vector>
+#include <unordered_map>
 
 #include "online.hpp"
 #include "room.hpp"
@@ -43,6 +46,13 @@ public:
         return;
     }
 
+    // 最多阻塞ms毫秒，超时返回false
+    bool wait_for(const int ms)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _cond.wait_for(lock, std::chrono::milliseconds(ms)) == std::cv_status::no_timeout;
+    }
+
     // 入队列
     void push(const T &data)
     {
@@ -76,6 +86,14 @@ public:
     }
 };
 
+// 开始匹配的结果
+enum match_add_result
+{
+    MATCH_ADDED = 0, // 已经加入匹配队列
+    MATCH_CANCELLED, // 查询分数期间玩家取消了匹配，没有加入
+    MATCH_FAILED     // 获取用户信息失败
+};
+
 // 管理匹配队列
 class matcher
 {
@@ -83,32 +101,52 @@ private:
     match_queue<uint64_t> _queue_bronze; // 青铜匹配队列
     match_queue<uint64_t> _queue_sliver; // 白银匹配队列
     match_queue<uint64_t> _queue_gold;   // 黄金匹配队列
+    match_queue<uint64_t> _queue_variant[VARIANT_COUNT]; // 其他变体各一个匹配队列，不分段位，下标为变体，标准规则不用
     std::thread _thread_bronze;          // 处理青铜队列的匹配的线程
     std::thread _thread_sliver;          // 处理白银队列的匹配的线程
     std::thread _thread_gold;            // 处理黄金队列的匹配的线程
     online_manager *_online_manager;
     room_manager *_room_manager;
     user_table *_user_table;
+    std::mutex _mutex;                              // 保证加入和移除队列不会交错
+    std::unordered_map<uint64_t, uint64_t> _pending; // 正在查询分数的玩家和这次开始匹配的编号
+    uint64_t _next_ticket;
+    std::vector<std::thread> _thread_variant; // 处理其他变体匹配队列的线程
 
 public:
     matcher(online_manager *online_manager, room_manager *room_manager, user_table *user_table)
-        : _online_manager(online_manager), _room_manager(room_manager), _user_table(user_table),
-          _thread_bronze(std::thread(&matcher::handler_bronze_match, this)),
-          _thread_sliver(std::thread(&matcher::handler_sliver_match, this)),
-          _thread_gold(std::thread(&matcher::handler_gold_match, this))
+        : _online_manager(online_manager), _room_manager(room_manager), _user_table(user_table), _next_ticket(0)
     {
+        // 所有成员初始化完毕后再启动匹配线程，线程一开始就会用到它们
+        _thread_bronze = std::thread(&matcher::handler_bronze_match, this);
+        _thread_sliver = std::thread(&matcher::handler_sliver_match, this);
+        _thread_gold = std::thread(&matcher::handler_gold_match, this);
+        for (int v = VARIANT_STANDARD_15 + 1; v < VARIANT_COUNT; v++)
+        {
+            _thread_variant.push_back(std::thread(&matcher::handler_match, this, std::ref(_queue_variant[v]), BOT_EASY,
+                                                  (game_variant)v));
+        }
         DLOG("游戏匹配模块处理完毕!!!");
     }
 
-    // 处理匹配功能
-    void handler_match(match_queue<uint64_t> &queue)
+    // 处理匹配功能，level为这个段位的机器人难度，variant为这个队列的对局变体，没有机器人的变体只匹配玩家
+    void handler_match(match_queue<uint64_t> &queue, const bot_level level,
+                       const game_variant variant = VARIANT_STANDARD_15)
     {
         while (true)
         {
             // 如果队列中的人数 小于2 则阻塞匹配队列线程
             while (queue.size() < 2)
             {
-                queue.wait();
+                // 一段时间内都只有一个人在等待，说明这个段位的玩家太少，为他匹配机器人
+                if (queue.wait_for(BOT_MATCH_TIMEOUT) == false && queue.size() == 1 && variant == VARIANT_STANDARD_15)
+                {
+                    uint64_t uid;
+                    if (queue.pop(uid))
+                    {
+                        match_bot(queue, uid, level);
+                    }
+                }
             }
             // DLOG("人数大于2个，开始匹配");
             // DLOG("!!!!!!!!!!");
@@ -129,7 +167,7 @@ public:
             {
                 // DLOG("2");
                 // 走到这里说明有一个人匹配了成功，可对方却取消匹配了，所以要将uid1重新加入匹配队列
-                add(uid1);
+                queue.push(uid1);
                 continue;
             }
             // 走到这里说明，两人匹配成功，但是匹配成功后，要判断两个人是否都还在游戏大厅
@@ -138,7 +176,7 @@ public:
             if (conn1.get() == nullptr) // uid1不在游戏大厅
             {
                 // DLOG("3");
-                add(uid2);
+                queue.push(uid2);
                 continue;
             }
             // DLOG("conn2");
@@ -146,17 +184,17 @@ public:
             if (conn2.get() == nullptr) // uid2不在游戏大厅
             {
                 // DLOG("4");
-                add(uid1);
+                queue.push(uid1);
                 continue;
             }
             // 走到这里说明，两个人终于匹配成功，为他们创建房间
             // DLOG("create_room");
-            room_ptr rp = _room_manager->create_room(uid1, uid2);
+            room_ptr rp = _room_manager->create_room(uid1, uid2, variant);
             if (rp.get() == nullptr)
             {
                 // DLOG("5");
-                add(uid1);
-                add(uid2);
+                queue.push(uid1);
+                queue.push(uid2);
                 continue;
             }
             // DLOG("!");
@@ -164,6 +202,7 @@ public:
             Json::Value response;
             response["optype"] = "match_success";
             response["result"] = true;
+            response["variant"] = VARIANT_NAME[variant];
             std::string body;
             // DLOG("!!!!!!!!!!");
             json_util::serialize(response, body);
@@ -174,34 +213,80 @@ public:
         return;
     }
 
+    // 为玩家创建机器人房间，机器人执黑，玩家先手
+    void match_bot(match_queue<uint64_t> &queue, const uint64_t &uid, const bot_level level)
+    {
+        server_t::connection_ptr conn = _online_manager->get_con_from_hall(uid);
+        if (conn.get() == nullptr) // 玩家已经不在游戏大厅
+        {
+            return;
+        }
+        room_ptr rp = _room_manager->create_bot_room(uid, BLACK_CHESS, level);
+        if (rp.get() == nullptr)
+        {
+            queue.push(uid);
+            return;
+        }
+        Json::Value response;
+        response["optype"] = "match_success";
+        response["result"] = true;
+        std::string body;
+        json_util::serialize(response, body);
+        conn->send(body);
+        return;
+    }
+
     // 处理青铜匹配队列
     void handler_bronze_match()
     {
-        return handler_match(_queue_bronze);
+        return handler_match(_queue_bronze, BOT_EASY);
     }
 
     // 处理白银匹配队列
     void handler_sliver_match()
     {
-        return handler_match(_queue_sliver);
+        return handler_match(_queue_sliver, BOT_NORMAL);
     }
 
     // 处理黄金匹配队列
     void handler_gold_match()
     {
-        return handler_match(_queue_gold);
+        return handler_match(_queue_gold, BOT_HARD);
     }
 
-    // 将玩家加入匹配队列
-    bool add(const uint64_t &uid)
+    // 开始匹配，在io线程中调用，返回这次开始匹配的编号，之后用它调用add
+    uint64_t begin_add(const uint64_t &uid)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        uint64_t ticket = ++_next_ticket;
+        _pending[uid] = ticket;
+        return ticket;
+    }
+
+    // 将玩家加入匹配队列，查询分数可能访问数据库，在阻塞任务线程中调用
+    // 查询期间玩家取消了匹配或者又重新开始了匹配，这次的编号已经过期，不加入队列
+    // 标准规则按分数分段位，其他变体各自只有一个队列，不需要查询分数
+    match_add_result add(const uint64_t &uid, const uint64_t &ticket, const game_variant variant = VARIANT_STANDARD_15)
     {
         // 根据玩家的分数，把不同的玩家加入到不同的匹配队列
         Json::Value message; // 通过用户的id可以将用户的信息传到message中
-        bool ret = _user_table->select_by_id(uid, message);
+        bool ret = variant != VARIANT_STANDARD_15 || _user_table->select_by_id(uid, message);
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto it = _pending.find(uid);
+        if (it == _pending.end() || it->second != ticket)
+        {
+            return MATCH_CANCELLED;
+        }
+        _pending.erase(it);
         if (ret == false)
         {
-            DLOG("获取用户 %d 信息失败", uid);
-            return false;
+            DLOG("获取用户 %lu 信息失败", uid);
+            return MATCH_FAILED;
+        }
+        if (variant != VARIANT_STANDARD_15)
+        {
+            _queue_variant[variant].push(uid);
+            return MATCH_ADDED;
         }
         uint64_t score = message["score"].asUInt64();
         if (score < 2000)
@@ -216,32 +301,22 @@ public:
         {
             _queue_gold.push(uid);
         }
-        return true;
+        return MATCH_ADDED;
     }
 
     // 将玩家从匹配队列中移除，当玩家取消匹配后调用
-    bool del(const uint64_t &uid)
+    // 不查询分数，从所有段位和变体的队列中移除，不访问数据库，可以在io线程中调用
+    void del(const uint64_t &uid)
     {
-        Json::Value message;
-        bool ret = _user_table->select_by_id(uid, message);
-        if (ret == false)
-        {
-            DLOG("获取用户 %d 信息失败", uid);
-            return false;
-        }
-        uint64_t score = message["score"].asUInt64();
-        if (score < 2000)
-        {
-            _queue_bronze.remove(uid);
-        }
-        else if (score < 3000)
-        {
-            _queue_sliver.remove(uid);
-        }
-        else
+        std::unique_lock<std::mutex> lock(_mutex);
+        _pending.erase(uid);
+        _queue_bronze.remove(uid);
+        _queue_sliver.remove(uid);
+        _queue_gold.remove(uid);
+        for (auto &queue : _queue_variant)
         {
-            _queue_gold.remove(uid);
+            queue.remove(uid);
         }
-        return true;
+        return;
     }
-};
\ No newline at end of file
+};
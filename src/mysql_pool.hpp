@@ -0,0 +1,331 @@
+// 数据库连接池模块，多个io线程各自借用一条连接并行访问数据库，不再共用一个mysql句柄
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+#include "util.hpp"
+#include "log.hpp"
+
+#define MYSQL_POOL_SIZE 8             // 连接数
+#define MYSQL_POOL_WAIT_MS 3000       // 借用连接时最多等待的时间，超时返回空连接
+#define MYSQL_POOL_PING_MS 10000      // 连接空闲超过这个时间，借出前先ping一次
+#define MYSQL_CLIENT_ERROR_MIN 2000   // mysql客户端错误码从2000开始，出现时连接可能已经断开
+#define MYSQL_POOL_STMTS 16           // 每条连接最多缓存的预处理语句数
+
+class mysql_pool;
+
+// 池中的一条连接
+struct mysql_slot
+{
+    MYSQL *mysql; // 连接失败或者断开后为nullptr，借出时重新连接
+    bool broken;  // 执行语句时出现客户端错误，归还后下次借出时重新连接
+    std::chrono::steady_clock::time_point last_used;
+    MYSQL_STMT *stmts[MYSQL_POOL_STMTS]; // 这条连接上已经准备好的语句，按语句编号存放，重新连接时全部关闭
+
+    // 关闭预处理语句和连接
+    void close()
+    {
+        for (auto &stmt : stmts)
+        {
+            if (stmt != nullptr)
+            {
+                mysql_stmt_close(stmt);
+                stmt = nullptr;
+            }
+        }
+        mysql_util::mysql_destroy(mysql);
+        mysql = nullptr;
+    }
+};
+
+// 借出的连接，析构时自动归还，不能复制只能移动
+class mysql_guard
+{
+private:
+    mysql_pool *_pool;
+    mysql_slot *_slot;
+
+public:
+    mysql_guard(mysql_pool *pool = nullptr, mysql_slot *slot = nullptr)
+        : _pool(pool), _slot(slot)
+    {
+    }
+
+    mysql_guard(mysql_guard &&other)
+        : _pool(other._pool), _slot(other._slot)
+    {
+        other._slot = nullptr;
+    }
+
+    mysql_guard(const mysql_guard &) = delete;
+    mysql_guard &operator=(const mysql_guard &) = delete;
+
+    ~mysql_guard();
+
+    // 没有借到连接时为false
+    explicit operator bool() const
+    {
+        return _slot != nullptr;
+    }
+
+    MYSQL *get() const
+    {
+        return _slot->mysql;
+    }
+
+    // 执行语句，出现客户端错误时标记连接，归还后由连接池重新连接
+    bool exec(const std::string &sql)
+    {
+        if (mysql_util::mysql_exec(_slot->mysql, sql))
+        {
+            return true;
+        }
+        check_error();
+        return false;
+    }
+
+    // 取结果集等失败后调用，根据错误码判断连接是否还能用
+    void check_error()
+    {
+        if (mysql_errno(_slot->mysql) >= MYSQL_CLIENT_ERROR_MIN)
+        {
+            _slot->broken = true;
+        }
+    }
+
+    // 取出这条连接上编号为id的预处理语句，第一次使用时准备，之后直接复用，失败返回nullptr
+    MYSQL_STMT *prepare(const int id, const char *sql)
+    {
+        MYSQL_STMT *&stmt = _slot->stmts[id];
+        if (stmt != nullptr)
+        {
+            return stmt;
+        }
+        stmt = mysql_stmt_init(_slot->mysql);
+        if (stmt == nullptr)
+        {
+            check_error();
+            return nullptr;
+        }
+        if (mysql_stmt_prepare(stmt, sql, strlen(sql)) != 0)
+        {
+            ELOG("mysql prepare failed : %s , reason : %s", sql, mysql_stmt_error(stmt));
+            stmt_error(stmt);
+            mysql_stmt_close(stmt);
+            stmt = nullptr;
+            return nullptr;
+        }
+        return stmt;
+    }
+
+    // 用params作为参数执行预处理语句，results不为空时把唯一的一行结果取到results中，结果不是正好一行时返回false
+    bool execute(MYSQL_STMT *stmt, MYSQL_BIND *params, MYSQL_BIND *results = nullptr)
+    {
+        if ((params != nullptr && mysql_stmt_bind_param(stmt, params)) || mysql_stmt_execute(stmt) != 0)
+        {
+            ELOG("mysql stmt execute failed : %s", mysql_stmt_error(stmt));
+            stmt_error(stmt);
+            return false;
+        }
+        if (results == nullptr)
+        {
+            return true;
+        }
+        bool ret = false;
+        if (mysql_stmt_bind_result(stmt, results) || mysql_stmt_store_result(stmt) != 0)
+        {
+            ELOG("mysql stmt store result failed : %s", mysql_stmt_error(stmt));
+            stmt_error(stmt);
+        }
+        else if (mysql_stmt_num_rows(stmt) == 1)
+        {
+            int status = mysql_stmt_fetch(stmt);
+            ret = status == 0 || status == MYSQL_DATA_TRUNCATED;
+        }
+        mysql_stmt_free_result(stmt);
+        return ret;
+    }
+
+    // 预处理语句出错后调用，根据错误码判断连接是否还能用
+    void stmt_error(MYSQL_STMT *stmt)
+    {
+        if (mysql_stmt_errno(stmt) >= MYSQL_CLIENT_ERROR_MIN)
+        {
+            _slot->broken = true;
+        }
+    }
+};
+
+// 固定大小的连接池：启动时建立所有连接，借用时没有空闲连接则等待，超时返回空连接
+// 空闲较久的连接借出前先ping，断开的连接在借出时重新建立，不影响其他连接
+class mysql_pool
+{
+private:
+    std::string _host;
+    std::string _user;
+    std::string _password;
+    std::string _database;
+    uint16_t _port;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::vector<mysql_slot> _slots;  // 所有连接，大小在构造后不再变化
+    std::vector<mysql_slot *> _idle; // 空闲连接，后进先出，最近用过的连接最先借出
+
+    uint64_t _checkouts;   // 借出次数
+    uint64_t _waits;       // 需要等待的借出次数
+    uint64_t _timeouts;    // 等待超时的次数
+    uint64_t _wait_us;     // 累计等待时间
+    uint64_t _max_wait_us; // 最长的一次等待时间
+    uint64_t _peak;        // 同时借出的连接数峰值
+    uint64_t _reconnects;  // 重新建立连接的次数
+    uint64_t _failures;    // 重新连接失败的次数
+
+    // 检查借出的连接，需要时重新连接，失败时返回false，调用者不持有锁
+    bool ensure_alive(mysql_slot *slot)
+    {
+        if (slot->mysql != nullptr && slot->broken == false)
+        {
+            auto idle = std::chrono::steady_clock::now() - slot->last_used;
+            if (idle < std::chrono::milliseconds(MYSQL_POOL_PING_MS) || mysql_ping(slot->mysql) == 0)
+            {
+                return true;
+            }
+            DLOG("mysql ping failed : %s", mysql_error(slot->mysql));
+        }
+        slot->close();
+        slot->mysql = mysql_util::mysql_create(_host, _user, _password, _database, _port);
+        slot->broken = false;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _reconnects++;
+        if (slot->mysql == nullptr)
+        {
+            _failures++;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    mysql_pool(const std::string &host,
+               const std::string &user,
+               const std::string &password,
+               const std::string &database,
+               const uint16_t &port = 3306,
+               const size_t size = MYSQL_POOL_SIZE)
+        : _host(host), _user(user), _password(password), _database(database), _port(port),
+          _slots(size == 0 ? 1 : size), _checkouts(0), _waits(0), _timeouts(0), _wait_us(0), _max_wait_us(0),
+          _peak(0), _reconnects(0), _failures(0)
+    {
+        size_t connected = 0;
+        for (auto &slot : _slots)
+        {
+            slot.mysql = mysql_util::mysql_create(_host, _user, _password, _database, _port);
+            slot.broken = false;
+            std::fill(std::begin(slot.stmts), std::end(slot.stmts), nullptr);
+            slot.last_used = std::chrono::steady_clock::now();
+            _idle.push_back(&slot);
+            if (slot.mysql != nullptr)
+            {
+                connected++;
+            }
+        }
+        ILOG("mysql pool connected %zu/%zu", connected, _slots.size());
+    }
+
+    ~mysql_pool()
+    {
+        for (auto &slot : _slots)
+        {
+            slot.close();
+        }
+    }
+
+    // 借用一条连接，超时或者重新连接失败时返回空连接，调用者需要先判断
+    mysql_guard acquire()
+    {
+        mysql_slot *slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_idle.empty())
+            {
+                auto start = std::chrono::steady_clock::now();
+                bool ready = _cond.wait_for(lock, std::chrono::milliseconds(MYSQL_POOL_WAIT_MS),
+                                            [this]() { return _idle.empty() == false; });
+                uint64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::steady_clock::now() - start).count();
+                _waits++;
+                _wait_us += waited;
+                if (waited > _max_wait_us)
+                {
+                    _max_wait_us = waited;
+                }
+                if (ready == false)
+                {
+                    _timeouts++;
+                    ELOG("mysql pool checkout timeout");
+                    return mysql_guard();
+                }
+            }
+            slot = _idle.back();
+            _idle.pop_back();
+            _checkouts++;
+            uint64_t in_use = _slots.size() - _idle.size();
+            if (in_use > _peak)
+            {
+                _peak = in_use;
+            }
+        }
+        if (ensure_alive(slot) == false)
+        {
+            release(slot);
+            return mysql_guard();
+        }
+        return mysql_guard(this, slot);
+    }
+
+    // 归还连接，由mysql_guard析构时调用
+    void release(mysql_slot *slot)
+    {
+        slot->last_used = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idle.push_back(slot);
+        }
+        _cond.notify_one();
+    }
+
+    // 连接池的统计信息，wait_us为累计等待时间
+    void stats(uint64_t &size, uint64_t &in_use, uint64_t &peak, uint64_t &checkouts, uint64_t &waits,
+               uint64_t &timeouts, uint64_t &wait_us, uint64_t &max_wait_us, uint64_t &reconnects, uint64_t &failures)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        size = _slots.size();
+        in_use = _slots.size() - _idle.size();
+        peak = _peak;
+        checkouts = _checkouts;
+        waits = _waits;
+        timeouts = _timeouts;
+        wait_us = _wait_us;
+        max_wait_us = _max_wait_us;
+        reconnects = _reconnects;
+        failures = _failures;
+    }
+};
+
+inline mysql_guard::~mysql_guard()
+{
+    if (_slot != nullptr)
+    {
+        _pool->release(_slot);
+    }
+}
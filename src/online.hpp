@@ -1,95 +1,245 @@
 #pragma once
+#include <stdint.h>
+#include <atomic>
 #include <unordered_map>
 #include <mutex>
 
 #include "util.hpp"
 
-// 通过哈希表对游戏大厅和游戏房间的用户进行管理
+#define ONLINE_SHARDS 64 // 分片个数，按用户id分片，每片一把锁
+
+// 用户当前所在的位置
+enum presence_location
+{
+    PRESENCE_OFFLINE = 0, // 不在线，表中没有该用户的记录
+    PRESENCE_HALL,        // 在游戏大厅
+    PRESENCE_MATCHED,     // 已经匹配成功并创建了房间，还没有进入房间
+    PRESENCE_ROOM         // 在游戏房间
+};
+
+// 用户的在线记录，每个在线用户只有一条
+struct presence
+{
+    presence_location location;    // 所在位置
+    server_t::connection_ptr conn; // 当前位置的连接，匹配成功后大厅连接断开时为空
+    uint64_t room_id;              // 匹配成功后为房间id，在大厅时为0
+};
+
+// 通过一张在线表对游戏大厅和游戏房间的用户进行管理
+// 每个用户只有一条记录，位置的变化都是比较后再修改：只有当前位置符合预期时才修改，否则不做任何改变并返回false
+// 这样判断重复登录和进入大厅/房间是同一次查找，大厅到房间之间用户始终处于PRESENCE_MATCHED，不会有不在表中的空档
+// 在线表按用户id分成ONLINE_SHARDS片，每片有自己的锁，不同用户的查询落在不同分片上，多个io线程之间很少互相等待
 
 class online_manager
 {
 private:
-    std::mutex _mutex;                                                 // 定义互斥锁，保护对哈希表进行操作的时候是原子性的
-    std::unordered_map<uint64_t, server_t::connection_ptr> _hall_user; // 管理游戏大厅用户信息
-    std::unordered_map<uint64_t, server_t::connection_ptr> _game_user; // 管理游戏房间用户信息
+    struct shard
+    {
+        std::mutex mutex;                                 // 保护本分片的在线表
+        std::unordered_map<uint64_t, presence> presences; // 本分片用户的在线记录
+    };
+    shard _shards[ONLINE_SHARDS];
+    std::atomic<uint64_t> _acquires;  // 加锁总次数
+    std::atomic<uint64_t> _contended; // 加锁时锁已被其他线程持有的次数
+
+    shard &get_shard(const uint64_t &id)
+    {
+        return _shards[id % ONLINE_SHARDS];
+    }
+
+    // 给分片加锁，先尝试一次，失败说明发生了竞争，计数后再阻塞等待
+    std::unique_lock<std::mutex> lock_shard(shard &s)
+    {
+        _acquires.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(s.mutex, std::try_to_lock);
+        if (lock.owns_lock() == false)
+        {
+            _contended.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+        }
+        return lock;
+    }
+
+    // 获取用户在指定位置的连接，不在该位置返回空
+    server_t::connection_ptr get_con(const uint64_t &id, const presence_location location)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it == s.presences.end() || it->second.location != location)
+        {
+            return server_t::connection_ptr();
+        }
+        return it->second.conn;
+    }
+
+    // 获取用户当前所在的位置，不复制连接
+    presence_location get_location(const uint64_t &id)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        return it == s.presences.end() ? PRESENCE_OFFLINE : it->second.location;
+    }
+
 public:
-    // 插入用户到游戏大厅
-    void login_game_hall(const uint64_t &id, server_t::connection_ptr &con)
+    online_manager()
+        : _acquires(0), _contended(0)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _hall_user.insert(std::make_pair(id, con));
-        return;
     }
 
-    // 插入用户到游戏房间
-    void login_game_room(const uint64_t &id, server_t::connection_ptr &con)
+    // 进入游戏大厅：用户不在线，或者匹配成功后没有进入房间并且大厅连接已经断开时才能进入，否则为重复登录
+    bool login_game_hall(const uint64_t &id, server_t::connection_ptr &con)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _game_user.insert(std::make_pair(id, con));
-        return;
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it != s.presences.end() && (it->second.location != PRESENCE_MATCHED || it->second.conn.get() != nullptr))
+        {
+            return false;
+        }
+        s.presences[id] = presence{PRESENCE_HALL, con, 0};
+        return true;
     }
 
-    // 将用户从游戏大厅删除
-    void exit_game_hall(const uint64_t &id)
+    // 匹配成功：大厅 -> 已匹配，记录房间id，用户不在大厅返回false
+    bool match_game_room(const uint64_t &id, const uint64_t &room_id)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _hall_user.erase(id);
-        return;
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it == s.presences.end() || it->second.location != PRESENCE_HALL)
+        {
+            return false;
+        }
+        it->second.location = PRESENCE_MATCHED;
+        it->second.room_id = room_id;
+        return true;
     }
 
-    // 将用户从游戏房间删除
-    void exit_game_room(const uint64_t &id)
+    // 撤销匹配：已匹配 -> 大厅，用于另一个玩家已经离开大厅、房间创建失败的情况
+    void cancel_match(const uint64_t &id, const uint64_t &room_id)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _game_user.erase(id);
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it == s.presences.end() || it->second.location != PRESENCE_MATCHED || it->second.room_id != room_id)
+        {
+            return;
+        }
+        if (it->second.conn.get() == nullptr) // 大厅连接已经断开，直接下线
+        {
+            s.presences.erase(it);
+            return;
+        }
+        it->second.location = PRESENCE_HALL;
+        it->second.room_id = 0;
         return;
     }
 
-    // 判断当前用户是否在游戏大厅
-    bool is_in_game_hall(const uint64_t &id)
+    // 进入游戏房间：已匹配到该房间，或者不在线(重新连接)时才能进入，已在大厅或房间中为重复登录
+    bool login_game_room(const uint64_t &id, server_t::connection_ptr &con, const uint64_t &room_id)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        auto it = _hall_user.find(id);
-        if (it == _hall_user.end())
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it != s.presences.end() && (it->second.location != PRESENCE_MATCHED || it->second.room_id != room_id))
         {
             return false;
         }
+        s.presences[id] = presence{PRESENCE_ROOM, con, room_id};
         return true;
     }
 
-    // 判断当前用户是否在游戏房间
-    bool is_in_game_room(const uint64_t &id)
+    // 大厅连接断开：只处理这个连接自己的记录，被判为重复登录的连接断开时不会影响已登录的连接
+    // 在大厅中直接下线；已匹配的用户保留记录，只清空连接，等待进入房间
+    bool exit_game_hall(const uint64_t &id, const server_t::connection_ptr &con)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it == s.presences.end() || it->second.conn != con)
+        {
+            return false;
+        }
+        if (it->second.location == PRESENCE_HALL)
+        {
+            s.presences.erase(it);
+            return true;
+        }
+        if (it->second.location == PRESENCE_MATCHED)
+        {
+            it->second.conn.reset();
+            return true;
+        }
+        return false;
+    }
+
+    // 房间连接断开：只有这个连接确实在房间中时才下线并返回true，room_id带回用户所在的房间
+    bool exit_game_room(const uint64_t &id, const server_t::connection_ptr &con, uint64_t &room_id)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        auto it = _game_user.find(id);
-        if (it == _game_user.end())
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it == s.presences.end() || it->second.location != PRESENCE_ROOM || it->second.conn != con)
         {
             return false;
         }
+        room_id = it->second.room_id;
+        s.presences.erase(it);
         return true;
     }
 
-    // 获取用户在游戏大厅的信息指针
-    server_t::connection_ptr get_con_from_hall(const uint64_t &id)
+    // 获取用户的在线记录，不在线时location为PRESENCE_OFFLINE
+    presence get_presence(const uint64_t &id)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        auto it = _hall_user.find(id);
-        if (it == _hall_user.end())
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        if (it == s.presences.end())
         {
-            return server_t::connection_ptr();
+            return presence{PRESENCE_OFFLINE, server_t::connection_ptr(), 0};
         }
         return it->second;
     }
 
+    // 获取用户已匹配或所在的房间id，不在房间中返回0
+    uint64_t get_room_id(const uint64_t &id)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock = lock_shard(s);
+        auto it = s.presences.find(id);
+        return it == s.presences.end() ? 0 : it->second.room_id;
+    }
+
+    // 判断当前用户是否在游戏大厅
+    bool is_in_game_hall(const uint64_t &id)
+    {
+        return get_location(id) == PRESENCE_HALL;
+    }
+
+    // 判断当前用户是否在游戏房间
+    bool is_in_game_room(const uint64_t &id)
+    {
+        return get_location(id) == PRESENCE_ROOM;
+    }
+
+    // 获取用户在游戏大厅的信息指针
+    server_t::connection_ptr get_con_from_hall(const uint64_t &id)
+    {
+        return get_con(id, PRESENCE_HALL);
+    }
+
     // 获取用户在游戏房间的信息指针
     server_t::connection_ptr get_con_from_room(const uint64_t &id)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        auto it = _game_user.find(id);
-        if (it == _game_user.end())
-        {
-            return server_t::connection_ptr();
-        }
-        return it->second;
+        return get_con(id, PRESENCE_ROOM);
+    }
+
+    // 获取加锁次数和发生竞争的次数
+    void stats(uint64_t &acquires, uint64_t &contended)
+    {
+        acquires = _acquires.load(std::memory_order_relaxed);
+        contended = _contended.load(std::memory_order_relaxed);
     }
-};
\ No newline at end of file
+};
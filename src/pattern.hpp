@@ -0,0 +1,249 @@
+// 棋型模块，编译期生成按线估值用的棋型表
+#pragma once
+
+#include <stdint.h>
+
+#include "board.hpp"
+
+// 棋型，数值越大越强
+enum line_shape
+{
+    SHAPE_NONE = 0,
+    SHAPE_ONE,        // 只有一子
+    SHAPE_TWO,        // 眠二
+    SHAPE_OPEN_TWO,   // 活二
+    SHAPE_THREE,      // 眠三
+    SHAPE_OPEN_THREE, // 活三，再下一子成活四
+    SHAPE_FOUR,       // 冲四(含跳四)，再下一子成五
+    SHAPE_OPEN_FOUR,  // 活四，两端都能成五
+    SHAPE_FIVE,       // 成五
+    SHAPE_COUNT
+};
+
+// 每种棋型的分数
+static const int SHAPE_SCORE[SHAPE_COUNT] = {0, 1, 10, 50, 100, 1000, 1200, 20000, 100000};
+
+// 棋型表：以WIN+1个格子为一个窗口，窗口内己方棋子的位图和阻挡(对方棋子或棋盘外)的位图拼成下标
+// 下标 = 己方位图 | 阻挡位图 << (WIN+1)，表中存放这个窗口里己方最强的棋型
+// 整张表在编译期由constexpr构造函数生成，运行时只做查表
+// EXACT为true时按恰好WIN子获胜的规则生成：成WIN子时会连上窗口内相邻己方棋子的子窗口不算，长连不是成五
+template <int WIN, bool EXACT>
+struct pattern_table
+{
+    static constexpr int WIDTH = WIN + 1;              // 窗口宽度
+    static constexpr int SIZE = 1 << (2 * WIDTH);      // 表的大小
+    static constexpr uint32_t FULL = (1u << WIDTH) - 1; // 窗口内全部位
+
+    uint8_t shape[SIZE];
+
+    constexpr pattern_table()
+        : shape()
+    {
+        for (int index = 0; index < SIZE; index++)
+        {
+            shape[index] = (uint8_t)classify((uint32_t)index & FULL, (uint32_t)index >> WIDTH);
+        }
+    }
+
+    // 统计[from, from+len)内的1的个数
+    static constexpr int count(const uint32_t bits, const int from, const int len)
+    {
+        int n = 0;
+        for (int i = from; i < from + len; i++)
+        {
+            n += (bits >> i) & 1;
+        }
+        return n;
+    }
+
+    // 判断一个窗口的棋型
+    static constexpr int classify(const uint32_t own, const uint32_t blocked)
+    {
+        if ((own & blocked) != 0) // 同一格既有己方棋子又被阻挡，下标不合法
+        {
+            return SHAPE_NONE;
+        }
+        // 窗口两端为空、中间WIN-1格不被阻挡时，才可能是活棋型
+        bool ends_empty = ((own | blocked) & 1) == 0 && (((own | blocked) >> WIN) & 1) == 0;
+        bool inner_free = count(blocked, 1, WIN - 1) == 0;
+        int inner = count(own, 1, WIN - 1);
+        // 窗口里的两个长度为WIN的子窗口，不被阻挡时按己方棋子数判断
+        // 恰好WIN子的规则下，子窗口外侧相邻的一格是己方棋子时，在子窗口里成WIN子就是长连，不算
+        int best = 0;
+        for (int from = 0; from <= 1; from++)
+        {
+            bool overline = EXACT && ((own >> (from == 0 ? WIN : 0)) & 1) != 0;
+            if (count(blocked, from, WIN) == 0 && overline == false)
+            {
+                int n = count(own, from, WIN);
+                best = n > best ? n : best;
+            }
+        }
+
+        if (best == WIN)
+        {
+            return SHAPE_FIVE;
+        }
+        if (ends_empty && inner_free && inner == WIN - 1)
+        {
+            return SHAPE_OPEN_FOUR;
+        }
+        if (best == WIN - 1)
+        {
+            return SHAPE_FOUR;
+        }
+        if (ends_empty && inner_free && inner == WIN - 2)
+        {
+            return SHAPE_OPEN_THREE;
+        }
+        if (best == WIN - 2)
+        {
+            return SHAPE_THREE;
+        }
+        if (ends_empty && inner_free && inner == WIN - 3)
+        {
+            return SHAPE_OPEN_TWO;
+        }
+        if (best == WIN - 3)
+        {
+            return SHAPE_TWO;
+        }
+        if (best > 0)
+        {
+            return SHAPE_ONE;
+        }
+        return SHAPE_NONE;
+    }
+};
+
+// 机器人使用的标准规则(恰好五子获胜)棋型表，4096项
+typedef pattern_table<5, true> pattern_five;
+static constexpr pattern_five PATTERN_FIVE{};
+
+// 编译期检查几个典型窗口，第i格对应第i位，X为己方棋子，O为阻挡，_为空
+#define PATTERN_FIVE_AT(own, blocked) PATTERN_FIVE.shape[(own) | ((blocked) << pattern_five::WIDTH)]
+static_assert(PATTERN_FIVE_AT(0x1F, 0x00) == SHAPE_FIVE, "XXXXX_");
+static_assert(PATTERN_FIVE_AT(0x3E, 0x01) == SHAPE_FIVE, "OXXXXX");
+static_assert(PATTERN_FIVE_AT(0x1E, 0x00) == SHAPE_OPEN_FOUR, "_XXXX_");
+static_assert(PATTERN_FIVE_AT(0x1E, 0x01) == SHAPE_FOUR, "OXXXX_");
+static_assert(PATTERN_FIVE_AT(0x17, 0x00) == SHAPE_FOUR, "XXX_X_");
+static_assert(PATTERN_FIVE_AT(0x0E, 0x00) == SHAPE_OPEN_THREE, "_XXX__");
+static_assert(PATTERN_FIVE_AT(0x16, 0x00) == SHAPE_OPEN_THREE, "_XX_X_");
+static_assert(PATTERN_FIVE_AT(0x0E, 0x01) == SHAPE_THREE, "OXXX__");
+static_assert(PATTERN_FIVE_AT(0x06, 0x00) == SHAPE_OPEN_TWO, "_XX___");
+static_assert(PATTERN_FIVE_AT(0x06, 0x01) == SHAPE_TWO, "OXX___");
+static_assert(PATTERN_FIVE_AT(0x06, 0x21) == SHAPE_NONE, "OXX__O");
+static_assert(PATTERN_FIVE_AT(0x1E, 0x21) == SHAPE_NONE, "OXXXXO");
+static_assert(PATTERN_FIVE_AT(0x3F, 0x00) == SHAPE_NONE, "XXXXXX");
+static_assert(PATTERN_FIVE_AT(0x2F, 0x00) == SHAPE_NONE, "XXXX_X");
+static_assert(PATTERN_FIVE_AT(0x3D, 0x00) == SHAPE_NONE, "X_XXXX");
+static_assert(PATTERN_FIVE_AT(0x0F, 0x00) == SHAPE_FOUR, "XXXX__");
+#undef PATTERN_FIVE_AT
+
+// 恰好五子的规则下，整条线上不可能再成五的格子：长连(六子及以上)中的棋子，以及再下一子就成长连的空位
+// 一个窗口只看得到六格，窗口外侧的棋子只能在整条线上排除，查表前把这些格子当作阻挡
+inline uint32_t overline_cells(const uint32_t own, const uint32_t space)
+{
+    // 六格里有五个己方棋子时一定有三连，大部分线上没有三连，直接返回
+    if ((own & (own >> 1) & (own >> 2)) == 0)
+    {
+        return 0;
+    }
+    // 第b位表示向左(低位)或向右(高位)连续b格都是己方棋子
+    uint32_t left[6], right[6];
+    left[0] = right[0] = ~0u;
+    for (int b = 1; b <= 5; b++)
+    {
+        left[b] = left[b - 1] & (own << b);
+        right[b] = right[b - 1] & (own >> b);
+    }
+    // 长连中的棋子：它自己和一侧连续a子、另一侧连续5-a子都是己方棋子
+    // 再下一子就成长连的空位：两侧共有连续5个己方棋子
+    uint32_t dead = 0;
+    for (int a = 0; a <= 5; a++)
+    {
+        dead |= left[a] & right[5 - a];
+    }
+    return dead & (own | space);
+}
+
+// 计算一条线上某一方最强的棋型，按恰好五子获胜的标准规则
+// own为己方位图，blocked为对方棋子和棋盘外的位图，mask为这条线落在棋盘内的位
+// 整条线左移一位，让线首之前的格子也作为阻挡出现在窗口里，然后按窗口逐个查表
+inline int line_shape(const uint32_t own, const uint32_t opp, const uint32_t mask)
+{
+    const int width = pattern_five::WIDTH;
+    uint32_t dead = overline_cells(own, mask & ~own & ~opp);
+    uint32_t o = (own & ~dead) << 1;
+    uint32_t b = ((opp | dead | ~mask) << 1) | 1;
+    int lo = __builtin_ctz(mask);
+    int hi = 31 - __builtin_clz(mask);
+    int shape = SHAPE_NONE;
+    // 左移后，线上第lo-1格到第hi+1格对应第lo位到第hi+2位
+    for (int i = lo; i + width <= hi + 3; i++)
+    {
+        uint32_t window = (o >> i) & pattern_five::FULL;
+        if (window == 0)
+        {
+            continue;
+        }
+        int s = PATTERN_FIVE.shape[window | (((b >> i) & pattern_five::FULL) << width)];
+        shape = s > shape ? s : shape;
+    }
+    return shape;
+}
+
+// 按整条线判断成五点和活四的工具，line为己方位图，space为空位位图，pos为线上某个己方棋子的位
+// 连珠禁手检测和算杀都用它们只检查经过某一子的线
+struct line_threat
+{
+    // 线上距离pos不超过4格的位
+    static uint32_t near(const int pos)
+    {
+        return pos >= 4 ? 0x1FFu << (pos - 4) : 0x1FFu >> (4 - pos);
+    }
+
+    // 线上再下一子就能让经过pos的连子恰好成五的空位
+    static uint32_t five_points(const uint32_t own, const uint32_t space, const int pos)
+    {
+        uint32_t points = 0;
+        for (uint32_t rest = space & near(pos); rest != 0; rest &= rest - 1)
+        {
+            int e = __builtin_ctz(rest);
+            if (bit_board::run_at(own | (1u << e), pos) == 5)
+            {
+                points |= 1u << e;
+            }
+        }
+        return points;
+    }
+
+    // 两个成五点是否是同一个活四的两端，即相距5格且中间全是己方棋子
+    static bool straight_four(const uint32_t own, const uint32_t points)
+    {
+        if (__builtin_popcount(points) != 2)
+        {
+            return false;
+        }
+        int lo = __builtin_ctz(points);
+        int hi = 31 - __builtin_clz(points);
+        uint32_t inner = ((1u << hi) - 1) & ~((1u << (lo + 1)) - 1);
+        return hi - lo == 5 && (own & inner) == inner;
+    }
+
+    // 线上再下一子就能形成经过pos的活四的空位，不为0说明经过pos有活三
+    static uint32_t four_points(const uint32_t own, const uint32_t space, const int pos)
+    {
+        uint32_t points = 0;
+        for (uint32_t rest = space & near(pos); rest != 0; rest &= rest - 1)
+        {
+            int e = __builtin_ctz(rest);
+            uint32_t own2 = own | (1u << e);
+            if (straight_four(own2, five_points(own2, space & ~(1u << e), pos)))
+            {
+                points |= 1u << e;
+            }
+        }
+        return points;
+    }
+};
@@ -0,0 +1,188 @@
+// 对象池模块，房间和session连同shared_ptr的控制块从池中分配，匹配高峰时不反复向通用分配器申请和释放
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <mutex>
+#include <vector>
+
+#define POOL_CHUNK_BLOCKS 64 // 池中没有空闲块时，一次向系统申请的块数
+
+// 定长块的对象池：第一次分配时确定块大小，之后按块大小分配，释放的块挂到空闲链表上复用，内存不归还系统
+// 池的统计信息用于观察峰值，启动时用reserve按峰值预先分配
+class object_pool
+{
+private:
+    union block
+    {
+        block *next; // 空闲时指向下一个空闲块
+        max_align_t align;
+    };
+    std::mutex _mutex;
+    size_t _block_size;          // 块大小，第一次分配时确定，0表示还没有确定
+    size_t _reserve;             // 块大小确定之前请求预先分配的块数
+    block *_free;                // 空闲链表
+    std::vector<char *> _chunks; // 向系统申请的内存
+    uint64_t _capacity;          // 总块数
+    uint64_t _in_use;            // 使用中的块数
+    uint64_t _peak;              // 使用中块数的峰值
+    uint64_t _allocs;            // 从池中分配的次数
+    uint64_t _fallbacks;         // 大小不符、改用通用分配器的次数
+
+    // 申请count块新内存并挂到空闲链表上，调用者持有锁
+    void grow(const size_t count)
+    {
+        size_t stride = (_block_size + sizeof(block) - 1) / sizeof(block) * sizeof(block);
+        char *chunk = static_cast<char *>(::operator new(stride * count));
+        _chunks.push_back(chunk);
+        for (size_t i = 0; i < count; i++)
+        {
+            block *b = reinterpret_cast<block *>(chunk + i * stride);
+            b->next = _free;
+            _free = b;
+        }
+        _capacity += count;
+    }
+
+public:
+    object_pool()
+        : _block_size(0), _reserve(0), _free(nullptr), _capacity(0), _in_use(0), _peak(0),
+          _allocs(0), _fallbacks(0)
+    {
+    }
+
+    ~object_pool()
+    {
+        for (char *chunk : _chunks)
+        {
+            ::operator delete(chunk);
+        }
+    }
+
+    object_pool(const object_pool &) = delete;
+    object_pool &operator=(const object_pool &) = delete;
+
+    // 分配size字节，大小和池的块大小不符时改用通用分配器
+    void *allocate(const size_t size)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_block_size == 0)
+            {
+                _block_size = size;
+                grow(_reserve > POOL_CHUNK_BLOCKS ? _reserve : POOL_CHUNK_BLOCKS);
+            }
+            if (size <= _block_size)
+            {
+                if (_free == nullptr)
+                {
+                    grow(POOL_CHUNK_BLOCKS);
+                }
+                block *b = _free;
+                _free = b->next;
+                _allocs++;
+                if (++_in_use > _peak)
+                {
+                    _peak = _in_use;
+                }
+                return b;
+            }
+            _fallbacks++;
+        }
+        return ::operator new(size);
+    }
+
+    // 释放allocate分配的内存，size必须和分配时相同
+    void deallocate(void *p, const size_t size)
+    {
+        if (size > _block_size)
+        {
+            ::operator delete(p);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        block *b = static_cast<block *>(p);
+        b->next = _free;
+        _free = b;
+        _in_use--;
+    }
+
+    // 预先分配，使池中至少有count块，块大小还没有确定时推迟到第一次分配
+    void reserve(const size_t count)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_block_size == 0)
+        {
+            _reserve = count;
+            return;
+        }
+        if (count > _capacity)
+        {
+            grow(count - _capacity);
+        }
+    }
+
+    // 获取块大小、总块数、使用中块数、峰值、分配次数和改用通用分配器的次数
+    void stats(uint64_t &block_size, uint64_t &capacity, uint64_t &in_use, uint64_t &peak, uint64_t &allocs,
+               uint64_t &fallbacks)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        block_size = _block_size;
+        capacity = _capacity;
+        in_use = _in_use;
+        peak = _peak;
+        allocs = _allocs;
+        fallbacks = _fallbacks;
+    }
+};
+
+// 每种对象一个进程内唯一的池，TAG用来区分不同的池
+template <class TAG>
+object_pool &pool_of()
+{
+    static object_pool pool;
+    return pool;
+}
+
+// 从TAG对应的池中分配的分配器，配合std::allocate_shared使用：
+// allocate_shared会把分配器rebind到控制块类型，对象和控制块在同一块内存里，一次从池中取出
+template <class T, class TAG = T>
+class pool_allocator
+{
+public:
+    typedef T value_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef pool_allocator<U, TAG> other;
+    };
+
+    pool_allocator() {}
+
+    template <class U>
+    pool_allocator(const pool_allocator<U, TAG> &) {}
+
+    T *allocate(const size_t n)
+    {
+        return static_cast<T *>(pool_of<TAG>().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, const size_t n)
+    {
+        pool_of<TAG>().deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const pool_allocator<U, TAG> &) const
+    {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const pool_allocator<U, TAG> &) const
+    {
+        return false;
+    }
+};
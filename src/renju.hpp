@@ -0,0 +1,124 @@
+// 连珠禁手模块，判断黑方的落子是否为三三、四四或长连禁手
+#pragma once
+
+#include <stdint.h>
+
+#include "board.hpp"
+#include "pattern.hpp"
+
+#define RENJU_MAX_DEPTH 3 // 判断活三时递归检查成活四的点是否禁手的最大层数
+
+// 禁手类型
+enum renju_forbid
+{
+    RENJU_NONE = 0,     // 不是禁手
+    RENJU_DOUBLE_THREE, // 三三禁手
+    RENJU_DOUBLE_FOUR,  // 四四禁手
+    RENJU_OVERLINE      // 长连禁手
+};
+
+// 禁手提示，与renju_forbid一一对应
+static const char *RENJU_REASON[] = {"", "黑方三三禁手，请重新选择位置下棋！！！",
+                                     "黑方四四禁手，请重新选择位置下棋！！！", "黑方长连禁手，请重新选择位置下棋！！！"};
+
+// 禁手检测：只检查经过落子点的四条线，不扫描整个棋盘
+// 每条线取出黑子位图和空位位图，成五、冲四、活三都用整条线的移位判断
+// 活三要求成活四的那个点本身不是禁手，所以会在线上的空位递归检查，递归层数有上限
+class renju_detector
+{
+public:
+    // 判断黑方在(row, col)落子是否为禁手，board为落子前的局面，(row, col)必须为空
+    // 检查过程中会临时落子，返回前恢复原局面
+    static renju_forbid check(bit_board &board, const int row, const int col, const int depth = 0)
+    {
+        board.put(row, col, BLACK_CHESS);
+        renju_forbid result = examine(board, row, col, depth);
+        board.remove(row, col, BLACK_CHESS);
+        return result;
+    }
+
+private:
+    // 判断已经落下的黑子(row, col)是否构成禁手
+    static renju_forbid examine(bit_board &board, const int row, const int col, const int depth)
+    {
+        uint32_t own[DIR_COUNT], space[DIR_COUNT];
+        int pos[DIR_COUNT];
+        bool overline = false;
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            board_dir dir = (board_dir)d;
+            int index = bit_board::line_index(row, col, dir);
+            pos[d] = bit_board::line_pos(row, col, dir);
+            own[d] = board.line_bits(BLACK_CHESS, dir, index);
+            space[d] = bit_board::line_mask(dir, index) & ~own[d] & ~board.line_bits(WHITE_CHESS, dir, index);
+            int run = bit_board::run_at(own[d], pos[d]);
+            if (run == 5) // 成五优先于禁手
+            {
+                return RENJU_NONE;
+            }
+            overline |= run > 5;
+        }
+        if (overline)
+        {
+            return RENJU_OVERLINE;
+        }
+
+        int fours = 0;
+        int line_four[DIR_COUNT];
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            line_four[d] = count_four(own[d], space[d], pos[d]);
+            fours += line_four[d];
+        }
+        if (fours >= 2)
+        {
+            return RENJU_DOUBLE_FOUR;
+        }
+
+        int threes = 0;
+        for (int d = 0; d < DIR_COUNT && threes < 2; d++)
+        {
+            if (line_four[d] == 0 && open_three(board, (board_dir)d, row, col, own[d], space[d], pos[d], depth))
+            {
+                threes++;
+            }
+        }
+        return threes >= 2 ? RENJU_DOUBLE_THREE : RENJU_NONE;
+    }
+
+    // 经过pos的这条线上有几个四，活四算一个，同一条线上两个冲四(如 X.XXX.X)算两个
+    static int count_four(const uint32_t own, const uint32_t space, const int pos)
+    {
+        uint32_t points = line_threat::five_points(own, space, pos);
+        if (points == 0)
+        {
+            return 0;
+        }
+        if (line_threat::straight_four(own, points))
+        {
+            return 1;
+        }
+        return __builtin_popcount(points) >= 2 ? 2 : 1;
+    }
+
+    // 经过pos的这条线上是否有活三：存在一个空位，下在那里能形成经过pos的活四，并且那个空位不是禁手
+    static bool open_three(bit_board &board, const board_dir dir, const int row, const int col,
+                           const uint32_t own, const uint32_t space, const int pos, const int depth)
+    {
+        for (uint32_t rest = line_threat::four_points(own, space, pos); rest != 0; rest &= rest - 1)
+        {
+            int e = __builtin_ctz(rest);
+            if (depth >= RENJU_MAX_DEPTH)
+            {
+                return true;
+            }
+            int r = row, c = col;
+            line_step(dir, e - pos, r, c);
+            if (check(board, r, c, depth + 1) == RENJU_NONE)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
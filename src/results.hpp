@@ -0,0 +1,244 @@
+// 对局结果写回模块，房间结算时只把结果放进队列，由后台线程成批写入数据库，对局结束不再等待数据库
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "db.hpp"
+#include "log.hpp"
+
+#define RESULT_SPILL_FILE "./results.spill" // 数据库不可用时保存对局结果的文件，恢复后重新写入
+#define RESULT_BATCH_MAX 1024               // 一批最多写入的结果数
+#define RESULT_RETRIES 3                    // 一批结果写入失败后的重试次数，仍然失败则写入落盘文件
+#define RESULT_RETRY_MS 200                 // 第一次重试前等待的时间，之后每次翻倍
+
+// 一局中一方的结果
+struct game_result
+{
+    uint64_t uid;
+    bool win;
+};
+
+// 后台线程取出队列中积累的所有结果，按用户合并后在一个事务中写入，失败时退避重试
+// 重试仍然失败时把结果追加到落盘文件，之后每次写入成功都先尝试补写落盘文件中的结果
+// 补写成功后删除文件；提交后、删除文件前进程退出时，这部分结果会被重复写入
+class result_writer
+{
+private:
+    user_table *_user_table;
+    std::string _spill_path;
+    std::deque<game_result> _queue; // 待写入的结果
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _stop;
+    bool _spilled; // 落盘文件中可能有未写入的结果
+    std::thread _thread;
+
+    uint64_t _pushed;   // 放入队列的结果数
+    uint64_t _written;  // 写入数据库的结果数
+    uint64_t _batches;  // 成功写入的批数
+    uint64_t _retries;  // 重试次数
+    uint64_t _spills;   // 写入落盘文件的结果数
+    uint64_t _replayed; // 从落盘文件补写的结果数
+    uint64_t _batch_us; // 成功写入的批累计耗时
+
+    // 按用户合并胜负场数
+    static std::vector<user_result> merge(const std::vector<game_result> &batch)
+    {
+        std::unordered_map<uint64_t, size_t> index;
+        std::vector<user_result> results;
+        for (auto &r : batch)
+        {
+            auto it = index.find(r.uid);
+            if (it == index.end())
+            {
+                it = index.insert(std::make_pair(r.uid, results.size())).first;
+                results.push_back(user_result{r.uid, 0, 0});
+            }
+            if (r.win)
+            {
+                results[it->second].wins++;
+            }
+            else
+            {
+                results[it->second].losses++;
+            }
+        }
+        return results;
+    }
+
+    // 把结果追加到落盘文件并刷到磁盘，每行为"uid 1|0"
+    bool spill(const std::vector<game_result> &batch)
+    {
+        std::string text;
+        for (auto &r : batch)
+        {
+            text += std::to_string(r.uid) + (r.win ? " 1\n" : " 0\n");
+        }
+        int fd = open(_spill_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0)
+        {
+            ELOG("open %s failed, %zu results lost", _spill_path.c_str(), batch.size());
+            return false;
+        }
+        bool ret = write(fd, text.data(), text.size()) == (ssize_t)text.size() && fsync(fd) == 0;
+        close(fd);
+        if (ret == false)
+        {
+            ELOG("write %s failed, %zu results lost", _spill_path.c_str(), batch.size());
+            return false;
+        }
+        ELOG("mysql unavailable, %zu results spilled to %s", batch.size(), _spill_path.c_str());
+        std::unique_lock<std::mutex> lock(_mutex);
+        _spills += batch.size();
+        _spilled = true;
+        return true;
+    }
+
+    // 读出落盘文件中的结果，在一个事务中写入，成功后删除文件
+    bool replay()
+    {
+        FILE *fp = fopen(_spill_path.c_str(), "r");
+        if (fp == nullptr)
+        {
+            return true;
+        }
+        std::vector<game_result> batch;
+        unsigned long long uid = 0;
+        int win = 0;
+        while (fscanf(fp, "%llu %d", &uid, &win) == 2)
+        {
+            batch.push_back(game_result{uid, win != 0});
+        }
+        fclose(fp);
+        if (batch.empty() == false && _user_table->apply_results(merge(batch)) == false)
+        {
+            return false;
+        }
+        unlink(_spill_path.c_str());
+        ILOG("replayed %zu results from %s", batch.size(), _spill_path.c_str());
+        std::unique_lock<std::mutex> lock(_mutex);
+        _replayed += batch.size();
+        _spilled = false;
+        return true;
+    }
+
+    // 写入一批结果，失败时退避重试，仍然失败则落盘；停止时不再等待重试
+    void flush(const std::vector<game_result> &batch)
+    {
+        std::vector<user_result> results = merge(batch);
+        int delay = RESULT_RETRY_MS;
+        for (int attempt = 0; attempt <= RESULT_RETRIES; attempt++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (_user_table->apply_results(results))
+            {
+                uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - start).count();
+                std::unique_lock<std::mutex> lock(_mutex);
+                _written += batch.size();
+                _batches++;
+                _batch_us += us;
+                return;
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_stop || attempt == RESULT_RETRIES)
+            {
+                break;
+            }
+            _retries++;
+            _cond.wait_for(lock, std::chrono::milliseconds(delay), [this]() { return _stop; });
+            delay *= 2;
+        }
+        spill(batch);
+    }
+
+    // 线程入口，不断取出队列中积累的结果写入，停止时写完队列中剩余的结果
+    void handler_task()
+    {
+        replay();
+        while (true)
+        {
+            std::vector<game_result> batch;
+            bool spilled = false;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (_queue.empty() && _stop == false)
+                {
+                    _cond.wait(lock);
+                }
+                if (_queue.empty() && _stop)
+                {
+                    return;
+                }
+                size_t count = std::min(_queue.size(), (size_t)RESULT_BATCH_MAX);
+                batch.assign(_queue.begin(), _queue.begin() + count);
+                _queue.erase(_queue.begin(), _queue.begin() + count);
+                spilled = _spilled;
+            }
+            // 先补写落盘文件中更早的结果，数据库仍不可用时本批直接落盘，不再逐批等待重试
+            if (spilled && replay() == false)
+            {
+                spill(batch);
+                continue;
+            }
+            flush(batch);
+        }
+    }
+
+public:
+    result_writer(user_table *user_table, const std::string &spill_path = RESULT_SPILL_FILE)
+        : _user_table(user_table), _spill_path(spill_path), _stop(false), _spilled(false), _pushed(0),
+          _written(0), _batches(0), _retries(0), _spills(0), _replayed(0), _batch_us(0)
+    {
+        _spilled = access(_spill_path.c_str(), F_OK) == 0;
+        _thread = std::thread(&result_writer::handler_task, this);
+        DLOG("对局结果写回模块初始化完毕！！！");
+    }
+
+    // 停止前写完队列中的结果，数据库不可用时落盘
+    ~result_writer()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+            _cond.notify_all();
+        }
+        _thread.join();
+        DLOG("对局结果写回模块销毁完毕！！！");
+    }
+
+    // 放入一方的结果，不访问数据库，立即返回
+    void push(const uint64_t &uid, const bool win)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _queue.push_back(game_result{uid, win});
+        _pushed++;
+        _cond.notify_one();
+    }
+
+    // 写回队列的统计信息，batch_us为成功写入的批累计耗时
+    void stats(uint64_t &pending, uint64_t &pushed, uint64_t &written, uint64_t &batches, uint64_t &retries,
+               uint64_t &spills, uint64_t &replayed, uint64_t &batch_us)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        pending = _queue.size();
+        pushed = _pushed;
+        written = _written;
+        batches = _batches;
+        retries = _retries;
+        spills = _spills;
+        replayed = _replayed;
+        batch_us = _batch_us;
+    }
+};
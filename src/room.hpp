@@ -5,18 +5,17 @@
 #include <string>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <functional>
 
-#include "db.hpp"
+#include "game.hpp"
+#include "bot.hpp"
+#include "results.hpp"
 #include "online.hpp"
+#include "slot_map.hpp"
+#include "pool.hpp"
 #include "log.hpp"
 #include "util.hpp"
 
-#define BOARD_ROW 15  // 棋盘行数
-#define BOARD_COL 15  // 棋盘列数
-#define WHITE_CHESS 1 // 白方的棋子
-#define BLACK_CHESS 2 // 黑方的棋子
-
 // 定义房间状态
 enum room_status
 {
@@ -25,7 +24,9 @@ enum room_status
 };
 
 // 房间类，用来维护两个用户匹配成功后，一个小范围的空间
-class room
+// 房间的所有请求都投递到房间自己的strand上执行：同一房间内按顺序串行，不同房间在多个io线程上并行，房间内部不再加锁
+// 机器人线程也通过strand操作房间，所以继承enable_shared_from_this，让投递的任务持有房间
+class room : public std::enable_shared_from_this<room>
 {
 private:
     int _play_count;                      // 玩家数量
@@ -33,15 +34,23 @@ private:
     uint64_t _white_id;                   // 白方id
     uint64_t _black_id;                   // 黑方id
     room_status _room_status;             // 房间状态
-    user_table *_user_table;              // user表管理类
+    result_writer *_results;              // 对局结果写回队列
     online_manager *_online_user;         // 用户在线信息类
-    std::vector<std::vector<int>> _board; // 棋盘
+    std::unique_ptr<game_base> _game;     // 对局，棋盘大小和规则由变体决定
+    std::vector<int> _moves;              // 双方依次的落子，row * 棋盘边长 + col，用于赛后复盘
+    websocketpp::lib::asio::io_service::strand _strand; // 房间的strand，串行执行房间的所有请求
+    int _bot_color;                       // 机器人执子的颜色，0表示房间里没有机器人
+    bot_level _bot_level;                 // 机器人难度
+    bool _bot_thinking;                   // 机器人是否正在思考，避免重复投递搜索任务
+    bot_worker *_bot_worker;              // 机器人线程池
 
 public:
-    room(const uint64_t &room_id, user_table *user_table, online_manager *online_user)
+    room(const uint64_t &room_id, result_writer *results, online_manager *online_user, bot_worker *bot_worker,
+         websocketpp::lib::asio::io_service &io_service, const game_variant variant = VARIANT_STANDARD_15)
         : _play_count(0), _room_id(room_id),
-          _room_status(GAME_START), _user_table(user_table), _online_user(online_user),
-          _board(BOARD_ROW, std::vector<int>(BOARD_COL, 0))
+          _room_status(GAME_START), _results(results), _online_user(online_user), _game(create_game(variant)),
+          _strand(io_service),
+          _bot_color(0), _bot_level(BOT_EASY), _bot_thinking(false), _bot_worker(bot_worker)
     {
         DLOG("房间创建成功");
     }
@@ -63,6 +72,37 @@ public:
         return _room_status;
     }
 
+    // 把任务投递到房间的strand上，下面的handle_*、bot_turn和broadcast都只能在strand上调用
+    void post(const std::function<void()> &task)
+    {
+        _strand.post(task);
+        return;
+    }
+
+    // 获取对局变体
+    game_variant get_variant()
+    {
+        return _game->variant();
+    }
+
+    // 获取棋盘边长
+    int get_board_size()
+    {
+        return _game->size();
+    }
+
+    // 获取下一步该下棋的用户id
+    uint64_t get_next_uid()
+    {
+        return _game->next_color() == WHITE_CHESS ? _white_id : _black_id;
+    }
+
+    // 该变体是否有机器人
+    bool bot_supported()
+    {
+        return _game->bot_supported();
+    }
+
     // 获取玩家数量
     int get_player_count()
     {
@@ -85,6 +125,22 @@ public:
         return;
     }
 
+    // 将机器人添加进房间，机器人坐chess_color一方，不计入玩家数量
+    void add_bot(const int chess_color, const bot_level level)
+    {
+        if (chess_color == WHITE_CHESS)
+        {
+            _white_id = BOT_USER_ID;
+        }
+        else
+        {
+            _black_id = BOT_USER_ID;
+        }
+        _bot_color = chess_color;
+        _bot_level = level;
+        return;
+    }
+
     // 获取白方用户id
     uint64_t get_white_id()
     {
@@ -120,7 +176,7 @@ public:
         uint64_t play_chess_id = request["uid"].asUInt64(); // 下棋用户的id
         // 1.在更新下棋位置的信息时，先判断对方有没有掉线，如果掉线了，直接获胜
         // DLOG("一");
-        if (_online_user->is_in_game_room(_white_id) == false)
+        if (_white_id != BOT_USER_ID && _online_user->is_in_game_room(_white_id) == false)
         {
             response["result"] = true;
             response["reason"] = "对方已掉线，恭喜你获胜了！！！";
@@ -128,7 +184,7 @@ public:
             return response;
         }
         // DLOG("二");
-        if (_online_user->is_in_game_room(_black_id) == false)
+        if (_black_id != BOT_USER_ID && _online_user->is_in_game_room(_black_id) == false)
         {
             response["result"] = true;
             response["reason"] = "对方已掉线，恭喜你获胜了！！！";
@@ -137,7 +193,13 @@ public:
         }
         // 2.进行下棋
         // DLOG("三");
-        if (_board[chess_row][chess_col] != 0) // 说明下棋的位置已经有棋子
+        if (_game->in_board(chess_row, chess_col) == false) // 下棋的位置不在棋盘内
+        {
+            response["result"] = false;
+            response["reason"] = "下棋位置不合法，请重新选择位置下棋！！！";
+            return response;
+        }
+        if (_game->empty(chess_row, chess_col) == false) // 说明下棋的位置已经有棋子
         {
             response["result"] = false;
             response["reason"] = "该位置已经有棋子，请重新选择位置下棋！！！";
@@ -154,16 +216,32 @@ public:
         {
             chess_color = BLACK_CHESS;
         }
-        _board[chess_row][chess_col] = chess_color;
-        // 3.下棋完成后判断是否获胜
+        if (_bot_color != 0 && chess_color != _game->next_color()) // 机器人房间由服务器保证轮流下棋
+        {
+            response["result"] = false;
+            response["reason"] = "还没有轮到你下棋！！！";
+            return response;
+        }
+        // 3.落子的同时判断是否获胜
         // DLOG("五");
-        uint64_t winner_id = check_win(chess_row, chess_col, chess_color);
-        if (winner_id != 0)
+        uint64_t winner_id = 0;
+        put_result put = _game->put(chess_row, chess_col, chess_color);
+        if (put == PUT_FORBIDDEN) // 连珠规则下黑方禁手，不落子
         {
-            response["reason"] = "五星连珠，恭喜你获胜了！！！";
+            response["result"] = false;
+            response["reason"] = _game->forbid_reason();
+            return response;
+        }
+        _moves.push_back(chess_row * _game->size() + chess_col);
+        if (put == PUT_WIN)
+        {
+            winner_id = chess_color == WHITE_CHESS ? _white_id : _black_id;
+            response["reason"] = _game->win_reason();
         }
         response["result"] = true;
         response["winner"] = (Json::UInt64)winner_id;
+        // 六子棋每回合下两子，由服务器告诉前端下一步轮到谁
+        response["next_uid"] = (Json::UInt64)get_next_uid();
         // DLOG("退出handler_chess函数");
         return response;
     }
@@ -211,8 +289,7 @@ public:
             response["row"] = -1;
             response["col"] = -1;
             response["winner"] = (Json::UInt64)winner_id;
-            _user_table->win(winner_id);
-            _user_table->lose(loser_id);
+            settle(winner_id, loser_id);
             _room_status = GAME_OVER;
             broadcast(response); // 广播信息
         }
@@ -252,9 +329,9 @@ public:
                 {
                     loser_id = _white_id;
                 }
-                _user_table->win(winner_id);
-                _user_table->lose(loser_id);
+                settle(winner_id, loser_id);
                 _room_status = GAME_OVER;
+                analyze(loser_id);
             }
         }
         else if (request["optype"].asString() == "chat")
@@ -272,134 +349,181 @@ public:
         json_util::serialize(response, body);
         DLOG("房间-广播动作：%s", body.c_str());
         broadcast(response);
+        bot_turn(); // 玩家下完棋后可能轮到机器人
         return;
     }
 
-    // 广播消息给房间所有用户
-    void broadcast(const Json::Value &response)
+    // 轮到机器人下棋时，把搜索任务投递给机器人线程池，io线程不等待搜索结果
+    void bot_turn()
     {
-        // 1.将需要广播的消息从json序列化成字符串
-        std::string body;
-        json_util::serialize(response, body);
-        // 2.获取客户端的连接
-        server_t::connection_ptr white_conn = _online_user->get_con_from_room(_white_id);
-        if (white_conn != nullptr)
-        {
-            white_conn->send(body);
-        }
-        else
-        {
-            DLOG("房间-白棋玩家获取连接失败");
-        }
-        server_t::connection_ptr black_conn = _online_user->get_con_from_room(_black_id);
-        if (black_conn != nullptr)
-        {
-            black_conn->send(body);
-        }
-        else
+        if (_bot_color == 0 || _bot_thinking || _room_status != GAME_START || _game->next_color() != _bot_color)
         {
-            DLOG("房间-黑棋玩家获取连接失败");
+            return;
         }
+        _bot_thinking = true;
+        std::shared_ptr<room> self = shared_from_this(); // 任务持有房间，防止思考期间房间被销毁
+        std::shared_ptr<game_base> snapshot(_game->clone()); // 机器人在局面副本上搜索
+        int chess_color = _bot_color;
+        level_config config = LEVEL_CONFIG[_bot_level];
+        _bot_worker->post([self, snapshot, chess_color, config]()
+                          {
+                              search_result result = snapshot->search(chess_color, config);
+                              self->post(std::bind(&room::bot_play, self, result)); });
         return;
     }
 
-private:
-    // 判断某一方向上是否五星连珠
-    // row和col为下棋的位置，offset为偏移量，依次判断横竖斜四个方向是否五星连珠
-    bool five(const int row, const int col, const int offset_row, const int offset_col, const int chess_color)
+    // 广播消息给房间所有用户
+    void broadcast(const Json::Value &response)
     {
-        // DLOG("进入five函数");
-        int count = 1;
-        int tmp_row = row;
-        int tmp_col = col;
-
-        tmp_row += offset_row;
-        tmp_col += offset_col;
-        while (tmp_row >= 0 && tmp_row < BOARD_ROW && tmp_col >= 0 && tmp_col < BOARD_COL)
+        // 1.将需要广播的消息从json序列化成字符串
+        std::string body;
+        json_util::serialize(response, body);
+        // 2.获取客户端的连接，机器人没有连接
+        if (_white_id != BOT_USER_ID)
         {
-            if (_board[tmp_row][tmp_col] == chess_color)
+            server_t::connection_ptr white_conn = _online_user->get_con_from_room(_white_id);
+            if (white_conn != nullptr)
             {
-                count++;
-                tmp_row += offset_row;
-                tmp_col += offset_col;
+                white_conn->send(body);
             }
             else
             {
-                break;
+                DLOG("房间-白棋玩家获取连接失败");
             }
         }
-        // DLOG("count : %d", count);
-        tmp_row = row;
-        tmp_col = col;
-        tmp_row -= offset_row;
-        tmp_col -= offset_col;
-        // DLOG("进入第二个while");
-        while (tmp_row >= 0 && tmp_row < BOARD_ROW && tmp_col >= 0 && tmp_col < BOARD_COL)
+        if (_black_id != BOT_USER_ID)
         {
-            if (_board[tmp_row][tmp_col] == chess_color)
+            server_t::connection_ptr black_conn = _online_user->get_con_from_room(_black_id);
+            if (black_conn != nullptr)
             {
-                count++;
-                tmp_row -= offset_row;
-                tmp_col -= offset_col;
+                black_conn->send(body);
             }
             else
             {
-                break;
+                DLOG("房间-黑棋玩家获取连接失败");
             }
         }
-        // DLOG("count : %d", count);
-        // DLOG("退出five函数");
-        if (count == 5)
+        return;
+    }
+
+private:
+    // 赛后复盘：在机器人线程中为输棋的玩家找出他错过的连续冲四杀法，找到后发给房间
+    // 算杀只支持15路标准规则
+    void analyze(const uint64_t &loser_id)
+    {
+        if (loser_id == BOT_USER_ID || _game->variant() != VARIANT_STANDARD_15 || _moves.empty())
         {
-            return true;
+            return;
         }
-        else
+        std::shared_ptr<room> self = shared_from_this();
+        std::vector<int> moves = _moves;
+        int chess_color = loser_id == _white_id ? WHITE_CHESS : BLACK_CHESS;
+        _bot_worker->post([self, moves, chess_color, loser_id]()
+                          {
+                              int step = 0;
+                              threat_result threat;
+                              if (find_missed_win(moves, chess_color, step, threat) == false)
+                              {
+                                  return;
+                              }
+                              Json::Value response;
+                              response["optype"] = "analysis";
+                              response["room_id"] = (Json::UInt64)self->get_room_id();
+                              response["uid"] = (Json::UInt64)loser_id;
+                              response["step"] = step + 1;
+                              response["row"] = threat.row;
+                              response["col"] = threat.col;
+                              response["depth"] = threat.depth;
+                              self->post(std::bind(&room::broadcast, self, response)); });
+        return;
+    }
+
+    // 机器人思考完毕，回到房间的strand上按照玩家下棋的流程落子
+    void bot_play(const search_result &result)
+    {
+        _bot_thinking = false;
+        if (_room_status != GAME_START || result.row < 0) // 对局已经结束或者棋盘已满
         {
-            return false;
+            return;
         }
+        DLOG("房间%lu-机器人落子(%d, %d) 分数：%d 深度：%d 节点数：%lu",
+             _room_id, result.row, result.col, result.score, result.depth, result.nodes);
+        Json::Value request;
+        request["optype"] = "put_chess";
+        request["room_id"] = (Json::UInt64)_room_id;
+        request["uid"] = (Json::UInt64)BOT_USER_ID;
+        request["row"] = result.row;
+        request["col"] = result.col;
+        handle_request(request);
+        return;
     }
 
-    // 判断是否获胜，如果获胜了，返回获胜者的id
-    uint64_t check_win(const int row, const int col, const int chess_color)
+    // 结算对局，双方的结果放入写回队列，由后台线程写入数据库，机器人不写数据库
+    void settle(const uint64_t &winner_id, const uint64_t &loser_id)
     {
-        // DLOG("进入check_win函数");
-        if (five(row, col, 1, 0, chess_color) ||
-            five(row, col, 0, 1, chess_color) ||
-            five(row, col, -1, -1, chess_color) ||
-            five(row, col, -1, 1, chess_color))
+        if (winner_id != BOT_USER_ID)
         {
-            if (chess_color == WHITE_CHESS)
-            {
-                return _white_id;
-            }
-            else
-            {
-                return _black_id;
-            }
+            _results->push(winner_id, true);
         }
-        // DLOG("退出check_win函数");
-        return 0;
+        if (loser_id != BOT_USER_ID)
+        {
+            _results->push(loser_id, false);
+        }
+        return;
     }
 };
 
 // typedef std::shared_ptr<room> room_ptr;
 using room_ptr = std::shared_ptr<room>;
 
+#define ROOM_POOL_RESERVE 256 // 启动时预先分配的房间个数，按/stats中房间池的峰值调整
+
 // 房间管理类
+// 房间存放在槽位表中，房间id就是槽位表的id，按房间id查找是一次带代数校验的数组访问
+// 用户所在的房间id记录在在线表的用户记录里，不再单独维护用户到房间的哈希表
 class room_manager
 {
 private:
-    uint64_t _next_room_id; // 给房间id进行编排序号
-    std::mutex _mutex;      // 互斥锁，用来保证哈希表的线程安全
-    user_table *_user_tb;
+    std::mutex _mutex; // 互斥锁，用来保证槽位表的线程安全
+    result_writer *_results;
     online_manager *_online_user;
-    std::unordered_map<uint64_t, room_ptr> _rooms; // 用来管理通过房间号来找到房间对象
-    std::unordered_map<uint64_t, uint64_t> _users; // 用来管理通过用户id找到房间id
+    bot_worker *_bot_worker;
+    websocketpp::lib::asio::io_service *_io_service; // 房间的strand所在的io_service
+    slot_map<room_ptr> _rooms;                       // 通过房间号来找到房间对象
+
+    // 占用一个槽位，得到新的房间id，房间创建好之前槽位里是空指针，查找时当作不存在
+    uint64_t alloc_room_id()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _rooms.insert(room_ptr());
+    }
+
+    // 把创建好的房间放进预先占用的槽位
+    void commit_room(const uint64_t &room_id, const room_ptr &rp)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        room_ptr *slot = _rooms.find(room_id);
+        if (slot != nullptr)
+        {
+            *slot = rp;
+        }
+        return;
+    }
+
+    // 房间创建失败，释放预先占用的槽位
+    void release_room_id(const uint64_t &room_id)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _rooms.erase(room_id);
+        return;
+    }
 
 public:
-    room_manager(user_table *user_tb, online_manager *_online_user)
-        : _next_room_id(1), _user_tb(user_tb), _online_user(_online_user)
+    room_manager(result_writer *results, online_manager *_online_user, bot_worker *bot_worker,
+                 websocketpp::lib::asio::io_service *io_service)
+        : _results(results), _online_user(_online_user), _bot_worker(bot_worker), _io_service(io_service)
     {
+        pool_of<room>().reserve(ROOM_POOL_RESERVE);
         DLOG("房间管理模块创建完毕！！！");
     }
 
@@ -408,98 +532,135 @@ public:
         DLOG("房间管理模块销毁完毕！！！");
     }
 
-    // 创建房间，当两个用户匹配成功时，为他们创建房间
-    room_ptr create_room(const uint64_t &id1, const uint64_t &id2)
+    // 创建房间，当两个用户匹配成功时，为他们创建房间，variant指定棋盘大小和规则
+    room_ptr create_room(const uint64_t &id1, const uint64_t &id2, const game_variant variant = VARIANT_STANDARD_15)
     {
         // DLOG("进入create_room函数");
-        // 在创建房间之前，先判断两个用户是否都还在大厅
-        if (_online_user->is_in_game_hall(id1) == false)
+        // 在创建房间之前，先把两个用户从大厅转为已匹配，任何一个已经不在大厅就撤销并返回
+        uint64_t room_id = alloc_room_id();
+        if (room_id == 0)
+        {
+            DLOG("房间数量已达上限，创建房间失败");
+            return room_ptr();
+        }
+        if (_online_user->match_game_room(id1, room_id) == false)
         {
             DLOG("用户：%lu 不在大厅中，创建房间失败", id1);
+            release_room_id(room_id);
             return room_ptr();
         }
-        if (_online_user->is_in_game_hall(id2) == false)
+        if (_online_user->match_game_room(id2, room_id) == false)
         {
             DLOG("用户：%lu 不在大厅中，创建房间失败", id2);
+            _online_user->cancel_match(id1, room_id);
+            release_room_id(room_id);
             return room_ptr();
         }
 
         // 说明两个用户都在大厅中，为他们创建房间
-        std::unique_lock<std::mutex> lock(_mutex);
-        room_ptr rp(new room(_next_room_id, _user_tb, _online_user));
+        room_ptr rp = std::allocate_shared<room>(pool_allocator<room>(), room_id, _results, _online_user, _bot_worker,
+                                                 *_io_service, variant);
         rp->add_white_user(id1);
         rp->add_black_user(id2);
-        _rooms.insert(std::make_pair(_next_room_id, rp));
-        _users.insert(std::make_pair(id1, _next_room_id));
-        _users.insert(std::make_pair(id2, _next_room_id));
-        _next_room_id++;
+        commit_room(room_id, rp);
         // DLOG("创建房间成功");
         return rp;
     }
 
-    // 通过房间id获取房间信息
-    room_ptr get_room_by_room_id(const uint64_t &room_id)
+    // 创建机器人房间，当匹配队列中人数太少时，为玩家匹配一个机器人对手
+    room_ptr create_bot_room(const uint64_t &uid, const int bot_color, const bot_level level,
+                             const game_variant variant = VARIANT_STANDARD_15)
     {
-        std::unique_lock<std::mutex> lock(_mutex);
-        auto it = _rooms.find(room_id);
-        if (it == _rooms.end())
+        uint64_t room_id = alloc_room_id();
+        if (room_id == 0)
+        {
+            DLOG("房间数量已达上限，创建机器人房间失败");
+            return room_ptr();
+        }
+        room_ptr rp = std::allocate_shared<room>(pool_allocator<room>(), room_id, _results, _online_user, _bot_worker,
+                                                 *_io_service, variant);
+        if (rp->bot_supported() == false)
         {
+            DLOG("变体：%d 没有机器人，创建机器人房间失败", (int)variant);
+            release_room_id(room_id);
             return room_ptr();
         }
-        return it->second;
+        if (_online_user->match_game_room(uid, room_id) == false)
+        {
+            DLOG("用户：%lu 不在大厅中，创建机器人房间失败", uid);
+            release_room_id(room_id);
+            return room_ptr();
+        }
+        if (bot_color == WHITE_CHESS)
+        {
+            rp->add_bot(WHITE_CHESS, level);
+            rp->add_black_user(uid);
+        }
+        else
+        {
+            rp->add_white_user(uid);
+            rp->add_bot(BLACK_CHESS, level);
+        }
+        commit_room(room_id, rp);
+        return rp;
     }
 
-    // 通过用户id获取房间信息
-    room_ptr get_room_by_user_id(const uint64_t &user_id)
+    // 通过房间id获取房间信息，id已经过期(房间已销毁、槽位被复用)时返回空
+    room_ptr get_room_by_room_id(const uint64_t &room_id)
     {
         std::unique_lock<std::mutex> lock(_mutex);
-        // 先通过用户id找到房间id
-        auto uit = _users.find(user_id);
-        if (uit == _users.end())
+        room_ptr *slot = _rooms.find(room_id);
+        if (slot == nullptr)
         {
             return room_ptr();
         }
-        auto rit = _rooms.find(uit->second);
-        if (rit == _rooms.end())
+        return *slot;
+    }
+
+    // 通过用户id获取房间信息，房间id从用户的在线记录中取得
+    room_ptr get_room_by_user_id(const uint64_t &user_id)
+    {
+        room_ptr rp = get_room_by_room_id(_online_user->get_room_id(user_id));
+        if (rp.get() == nullptr || (rp->get_white_id() != user_id && rp->get_black_id() != user_id))
         {
             return room_ptr();
         }
-        return rit->second;
+        return rp;
     }
 
     // 通过id销毁房间
     void remove_room(const uint64_t &room_id)
     {
-        // 先查找该房间，如果找到了才进行销毁
-        room_ptr rp = get_room_by_room_id(room_id);
-        if (rp == nullptr)
-        {
-            return;
-        }
-
         std::unique_lock<std::mutex> lock(_mutex);
-        uint64_t uid1 = rp->get_white_id();
-        uint64_t uid2 = rp->get_black_id();
-        _users.erase(uid1);
-        _users.erase(uid2);
         _rooms.erase(room_id);
         return;
     }
 
-    // 删除房间中指定用户，用于用户断开连接时调用
-    void remove_user(const uint64_t &user_id)
+    // 删除房间中指定用户，用于用户断开连接时调用，room_id为用户断开前所在的房间
+    void remove_user(const uint64_t &user_id, const uint64_t &room_id)
     {
-        // 先通过用户id查找房间在存不存在
-        room_ptr rp = get_room_by_user_id(user_id);
+        // 先通过房间id查找房间在存不存在
+        room_ptr rp = get_room_by_room_id(room_id);
         if (rp == nullptr)
         {
             return;
         }
-        rp->handle_exit(user_id);
-        if (rp->get_player_count() == 0)
-        {
-            remove_room(rp->get_room_id());
-        }
+        // 退出和房间里的下棋请求在同一个strand上排队，不会交错执行
+        rp->post([this, rp, user_id]()
+                 {
+                     rp->handle_exit(user_id);
+                     if (rp->get_player_count() == 0)
+                     {
+                         remove_room(rp->get_room_id());
+                     } });
         return;
     }
+
+    // 获取房间数和槽位数
+    void stats(uint64_t &rooms, uint64_t &slots)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        rooms = _rooms.size();
+        slots = _rooms.capacity();
+    }
 };
\ No newline at end of file
@@ -2,6 +2,9 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
 #include "util.hpp"
 #include "log.hpp"
@@ -10,19 +13,26 @@
 #include "room.hpp"
 #include "session.hpp"
 #include "matcher.hpp"
+#include "asset.hpp"
+#include "worker.hpp"
 
 #define WWWROOT "./wwwroot/"
+#define SERVER_IO_THREADS 0 // io线程数，0表示与CPU核数相同
 
 class gobang_server
 {
 private:
+    websocketpp::lib::asio::io_service _io_service; // 所有io线程共用的io_service，房间的strand也建立在它上面
     server_t _server;                 // 服务器类
-    std::string _wwwroot;             // web网页资源根目录
+    asset_cache _assets;              // web网页资源，全部缓存在内存中
     user_table _user_table;           // 数据库用户管理类
+    result_writer _results;           // 对局结果写回队列，必须在房间之前创建、之后销毁
     online_manager _online_manager;   // 在线用户管理类
+    bot_worker _bot_worker;           // 机器人线程池
     room_manager _room_manager;       // 房间管理类
     session_manager _session_manager; // session管理类
     matcher _matcher;                 // 匹配队列管理类
+    db_worker _db_worker;             // 访问数据库的http请求在这里执行，最先销毁，排队的任务仍能使用其他模块
 public:
     gobang_server(const std::string &host,
                   const std::string &username,
@@ -30,15 +40,16 @@ public:
                   const std::string &dbname,
                   const uint16_t &port = 3306,
                   const std::string &wwwroot = WWWROOT)
-        : _wwwroot(wwwroot),
+        : _assets(wwwroot),
           _user_table(host, username, password, dbname, port),
-          _room_manager(&_user_table, &_online_manager),
+          _results(&_user_table),
+          _room_manager(&_results, &_online_manager, &_bot_worker, &_io_service),
           _session_manager(&_server),
           _matcher(&_online_manager, &_room_manager, &_user_table)
     {
         // 对websocket的server类进行初始化
         _server.set_access_channels(websocketpp::log::alevel::none); // 关闭日志
-        _server.init_asio();
+        _server.init_asio(&_io_service);
         _server.set_reuse_addr(true); // 确保服务器重启时，能快速占用端口号
         // 初始化四个处理回调函数
         _server.set_http_handler(std::bind(&gobang_server::handler_http, this, std::placeholders::_1));
@@ -47,12 +58,27 @@ public:
         _server.set_message_handler(std::bind(&gobang_server::handler_message, this, std::placeholders::_1, std::placeholders::_2));
     }
 
-    // 启动服务器
-    void start(uint16_t port)
+    // 启动服务器，io_threads个线程同时运行事件循环，当前线程也是其中之一
+    void start(uint16_t port, int io_threads = SERVER_IO_THREADS)
     {
+        if (io_threads <= 0)
+        {
+            io_threads = std::max(1, (int)std::thread::hardware_concurrency());
+        }
         _server.listen(port);
         _server.start_accept();
+        std::vector<std::thread> threads;
+        for (int i = 1; i < io_threads; i++)
+        {
+            threads.push_back(std::thread([this]()
+                                          { _server.run(); }));
+        }
+        ILOG("服务器启动，io线程数：%d", io_threads);
         _server.run();
+        for (auto &t : threads)
+        {
+            t.join();
+        }
         return;
     }
 
@@ -162,7 +188,7 @@ private:
         // DLOG("----------------------------------------------------------------------------------------------------");
         // DLOG("进入information函数");
         // 1.获取cookie信息
-        std::string cookie_str = conn->get_request_header("Cookie");
+        const std::string &cookie_str = conn->get_request_header("Cookie");
         if (cookie_str.empty() == true)
         {
             DLOG("Cookie信息不存在");
@@ -170,19 +196,19 @@ private:
         }
 
         // 2.判断session是否存在
-        std::string val;
-        if (get_cookie_val(cookie_str, "SSID", val) == false)
+        uint64_t ssid = 0;
+        if (get_cookie_ssid(cookie_str, ssid) == false)
         {
             DLOG("session id信息不存在");
-            http_response(conn, websocketpp::http::status_code::bad_request, false, "session id不存在，请重新登录");
+            return http_response(conn, websocketpp::http::status_code::bad_request, false, "session id不存在，请重新登录");
         }
 
         // 3.通过session去获取会话的信息
-        session_ptr ssp = _session_manager.get_session_by_id(std::stol(val));
+        session_ptr ssp = _session_manager.get_session_by_id(ssid);
         if (ssp.get() == nullptr)
         {
             DLOG("session信息不存在");
-            http_response(conn, websocketpp::http::status_code::bad_request, false, "session信息不存在，请重新登录");
+            return http_response(conn, websocketpp::http::status_code::bad_request, false, "session信息不存在，请重新登录");
         }
 
         // 4.从数据库中通过会话信息获取用户信息
@@ -191,7 +217,7 @@ private:
         if (_user_table.select_by_id(uid, user_info) == false)
         {
             DLOG("数据库中不存在该用户信息");
-            http_response(conn, websocketpp::http::status_code::bad_request, false, "找不到用户信息，请重新登录");
+            return http_response(conn, websocketpp::http::status_code::bad_request, false, "找不到用户信息，请重新登录");
         }
         std::string body;
         json_util::serialize(user_info, body);
@@ -205,56 +231,199 @@ private:
         return;
     }
 
-    // 返回默认界面，即登录界面
-    void default_page(server_t::connection_ptr &conn)
+    // 对象池的统计信息
+    void pool_stats(object_pool &pool, Json::Value &info)
+    {
+        uint64_t block_size = 0, capacity = 0, in_use = 0, peak = 0, allocs = 0, fallbacks = 0;
+        pool.stats(block_size, capacity, in_use, peak, allocs, fallbacks);
+        info["block_size"] = (Json::UInt64)block_size;
+        info["capacity"] = (Json::UInt64)capacity;
+        info["in_use"] = (Json::UInt64)in_use;
+        info["peak"] = (Json::UInt64)peak;
+        info["allocs"] = (Json::UInt64)allocs;
+        info["fallbacks"] = (Json::UInt64)fallbacks;
+    }
+
+    // 返回服务器各模块的运行统计信息，用于观察负载和调整各种缓存的大小
+    void stats(server_t::connection_ptr &conn)
+    {
+        Json::Value stats_info;
+        uint64_t capacity = 0, used = 0, hits = 0, misses = 0, stores = 0;
+        position_cache::instance().stats(capacity, used, hits, misses, stores);
+        stats_info["position_cache"]["capacity"] = (Json::UInt64)capacity;
+        stats_info["position_cache"]["used"] = (Json::UInt64)used;
+        stats_info["position_cache"]["hits"] = (Json::UInt64)hits;
+        stats_info["position_cache"]["misses"] = (Json::UInt64)misses;
+        stats_info["position_cache"]["stores"] = (Json::UInt64)stores;
+        stats_info["bot"]["pending"] = (Json::UInt64)_bot_worker.pending();
+        stats_info["bot"]["idle_helpers"] = search_pool::instance().idle();
+        uint64_t acquires = 0, contended = 0;
+        _online_manager.stats(acquires, contended);
+        uint64_t rooms = 0, room_slots = 0, sessions = 0, session_slots = 0;
+        _room_manager.stats(rooms, room_slots);
+        _session_manager.stats(sessions, session_slots);
+        stats_info["rooms"]["count"] = (Json::UInt64)rooms;
+        stats_info["rooms"]["slots"] = (Json::UInt64)room_slots;
+        stats_info["sessions"]["count"] = (Json::UInt64)sessions;
+        stats_info["sessions"]["slots"] = (Json::UInt64)session_slots;
+        pool_stats(pool_of<room>(), stats_info["pools"]["room"]);
+        pool_stats(pool_of<session>(), stats_info["pools"]["session"]);
+        uint64_t files = 0, bytes = 0, gzip_bytes = 0, br_bytes = 0, reloads = 0;
+        _assets.stats(files, bytes, gzip_bytes, br_bytes, reloads);
+        stats_info["assets"]["files"] = (Json::UInt64)files;
+        stats_info["assets"]["bytes"] = (Json::UInt64)bytes;
+        stats_info["assets"]["gzip_bytes"] = (Json::UInt64)gzip_bytes;
+        stats_info["assets"]["br_bytes"] = (Json::UInt64)br_bytes;
+        stats_info["assets"]["reloads"] = (Json::UInt64)reloads;
+        uint64_t db_size = 0, db_in_use = 0, db_peak = 0, checkouts = 0, waits = 0, timeouts = 0, wait_us = 0,
+                 max_wait_us = 0, reconnects = 0, failures = 0;
+        _user_table.pool().stats(db_size, db_in_use, db_peak, checkouts, waits, timeouts, wait_us, max_wait_us,
+                                 reconnects, failures);
+        stats_info["mysql_pool"]["size"] = (Json::UInt64)db_size;
+        stats_info["mysql_pool"]["in_use"] = (Json::UInt64)db_in_use;
+        stats_info["mysql_pool"]["peak"] = (Json::UInt64)db_peak;
+        stats_info["mysql_pool"]["utilization"] = db_size == 0 ? 0.0 : (double)db_in_use / db_size;
+        stats_info["mysql_pool"]["checkouts"] = (Json::UInt64)checkouts;
+        stats_info["mysql_pool"]["waits"] = (Json::UInt64)waits;
+        stats_info["mysql_pool"]["timeouts"] = (Json::UInt64)timeouts;
+        stats_info["mysql_pool"]["avg_wait_us"] = waits == 0 ? 0.0 : (double)wait_us / waits;
+        stats_info["mysql_pool"]["max_wait_us"] = (Json::UInt64)max_wait_us;
+        stats_info["mysql_pool"]["reconnects"] = (Json::UInt64)reconnects;
+        stats_info["mysql_pool"]["reconnect_failures"] = (Json::UInt64)failures;
+        uint64_t pending = 0, pushed = 0, written = 0, batches = 0, retries = 0, spills = 0, replayed = 0, batch_us = 0;
+        _results.stats(pending, pushed, written, batches, retries, spills, replayed, batch_us);
+        stats_info["results"]["pending"] = (Json::UInt64)pending;
+        stats_info["results"]["pushed"] = (Json::UInt64)pushed;
+        stats_info["results"]["written"] = (Json::UInt64)written;
+        stats_info["results"]["batches"] = (Json::UInt64)batches;
+        stats_info["results"]["avg_batch_size"] = batches == 0 ? 0.0 : (double)written / batches;
+        stats_info["results"]["avg_batch_us"] = batches == 0 ? 0.0 : (double)batch_us / batches;
+        stats_info["results"]["retries"] = (Json::UInt64)retries;
+        stats_info["results"]["spilled"] = (Json::UInt64)spills;
+        stats_info["results"]["replayed"] = (Json::UInt64)replayed;
+        uint64_t worker_pending = 0, worker_peak = 0, completed = 0, rejected = 0, worker_wait_us = 0,
+                 worker_max_wait_us = 0, run_us = 0;
+        _db_worker.stats(worker_pending, worker_peak, completed, rejected, worker_wait_us, worker_max_wait_us, run_us);
+        stats_info["db_worker"]["pending"] = (Json::UInt64)worker_pending;
+        stats_info["db_worker"]["peak"] = (Json::UInt64)worker_peak;
+        stats_info["db_worker"]["completed"] = (Json::UInt64)completed;
+        stats_info["db_worker"]["rejected"] = (Json::UInt64)rejected;
+        stats_info["db_worker"]["avg_wait_us"] = completed == 0 ? 0.0 : (double)worker_wait_us / completed;
+        stats_info["db_worker"]["max_wait_us"] = (Json::UInt64)worker_max_wait_us;
+        stats_info["db_worker"]["avg_run_us"] = completed == 0 ? 0.0 : (double)run_us / completed;
+        uint64_t cache_size = 0, cache_capacity = 0, cache_hits = 0, cache_misses = 0, evictions = 0;
+        _user_table.cache().stats(cache_size, cache_capacity, cache_hits, cache_misses, evictions);
+        stats_info["user_cache"]["size"] = (Json::UInt64)cache_size;
+        stats_info["user_cache"]["capacity"] = (Json::UInt64)cache_capacity;
+        stats_info["user_cache"]["hits"] = (Json::UInt64)cache_hits;
+        stats_info["user_cache"]["misses"] = (Json::UInt64)cache_misses;
+        stats_info["user_cache"]["hit_ratio"] =
+            cache_hits + cache_misses == 0 ? 0.0 : (double)cache_hits / (cache_hits + cache_misses);
+        stats_info["user_cache"]["evictions"] = (Json::UInt64)evictions;
+        stats_info["online"]["shards"] = ONLINE_SHARDS;
+        stats_info["online"]["lock_acquires"] = (Json::UInt64)acquires;
+        stats_info["online"]["lock_contended"] = (Json::UInt64)contended;
+
+        std::string body;
+        json_util::serialize(stats_info, body);
+        conn->set_body(body);
+        conn->append_header("Content-Type", "application/json");
+        conn->set_status(websocketpp::http::status_code::ok);
+        return;
+    }
+
+    // 返回静态资源，路径为'/'时返回登录界面，找不到时返回404页面，都从内存中读取
+    // 浏览器缓存的版本还有效时返回304，不发送正文
+    void default_page(server_t::connection_ptr &conn, const str_view &url)
     {
         // DLOG("----------------------------------------------------------------------------------------------------");
         // DLOG("进入default_page函数");
-        websocketpp::http::parser::request req = conn->get_request();
-        std::string method = req.get_method();
-        std::string url = req.get_uri();
-
-        std::string path = _wwwroot + url; // 组合请求路径
-        if (path.back() == '/')            // 如果这里的if为真，说明请求的路径为:./wwwroot/
+        asset_ptr ap = _assets.find(url);
+        if (ap.get() == nullptr) // 资源不存在，返回404
+        {
+            ap = _assets.not_found();
+            conn->set_body(*ap->body);
+            conn->append_header("Content-Type", ap->mime);
+            conn->set_status(websocketpp::http::status_code::not_found);
+            return;
+        }
+        // 按Accept-Encoding挑选预先压缩好的内容
+        asset_variant variant = ap->select(asset_cache::accept_encoding(conn->get_request_header("Accept-Encoding")));
+        conn->append_header("ETag", *variant.etag);
+        conn->append_header("Last-Modified", ap->last_modified);
+        const std::string *cache_control = _assets.cache_control(url);
+        if (cache_control != nullptr)
         {
-            path += "login.html";
+            conn->append_header("Cache-Control", *cache_control);
         }
-
-        std::string body; // 将请求的内容进行返回
-        bool ret = read_util::read(path, body);
-        if (ret == false) // 如果获取login.html资源失败，则返回404
+        if (ap->gzip.get() != nullptr || ap->br.get() != nullptr) // 响应内容随Accept-Encoding变化，告诉中间缓存
         {
-            std::string not_found = _wwwroot + "404.html";
-            read_util::read(not_found, body);
+            conn->append_header("Vary", "Accept-Encoding");
+        }
+        if (ap->not_modified(conn->get_request_header("If-None-Match"), conn->get_request_header("If-Modified-Since")))
+        {
+            conn->set_status(websocketpp::http::status_code::not_modified);
+            return;
+        }
+        conn->set_body(*variant.body);
+        conn->append_header("Content-Type", ap->mime);
+        if (variant.encoding != nullptr)
+        {
+            conn->append_header("Content-Encoding", variant.encoding);
         }
-        conn->set_body(body);
         conn->set_status(websocketpp::http::status_code::ok);
         // DLOG("退出default_page函数");
         // DLOG("----------------------------------------------------------------------------------------------------");
         return;
     }
 
+    // 需要访问数据库的请求交给阻塞任务线程池执行，响应推迟到执行完后回到io线程发送，io线程不等待数据库
+    // 推迟期间io线程不会访问这个连接的响应，任务线程可以直接填写
+    void offload(server_t::connection_ptr &conn, void (gobang_server::*handler)(server_t::connection_ptr &))
+    {
+        if (conn->defer_http_response())
+        {
+            return http_response(conn, websocketpp::http::status_code::internal_server_error, false, "推迟响应失败");
+        }
+        bool posted = _db_worker.post([this, conn, handler]() mutable
+                                      {
+                                          (this->*handler)(conn);
+                                          _io_service.post([conn]()
+                                                           { conn->send_http_response(); });
+                                      });
+        if (posted == false)
+        {
+            http_response(conn, websocketpp::http::status_code::service_unavailable, false, "服务器繁忙，请稍后再试");
+            conn->send_http_response();
+        }
+        return;
+    }
+
     void handler_http(websocketpp::connection_hdl hdl)
     {
         server_t::connection_ptr conn = _server.get_con_from_hdl(hdl);
-        websocketpp::http::parser::request req = conn->get_request(); // 获取http请求
-        std::string method = req.get_method();                        // 获取http请求的方法
-        std::string url = req.get_uri();                              // 获取http请求的url
+        const websocketpp::http::parser::request &req = conn->get_request(); // 获取http请求，不复制
+        str_view method = req.get_method();                                  // 获取http请求的方法
+        str_view url = string_util::uri_path(req.get_uri());                 // 获取http请求的路径，去掉查询串
         if (method == "POST" && url == "/login")
         {
-            return login(conn); // 进行登录请求
+            return offload(conn, &gobang_server::login); // 进行登录请求
         }
         else if (method == "POST" && url == "/reg")
         {
-            return reg(conn); // 进行注册请求
+            return offload(conn, &gobang_server::reg); // 进行注册请求
         }
         else if (method == "GET" && url == "/information")
         {
-            return information(conn); // 后去用户信息请求，例如用户的分数、id等
+            return offload(conn, &gobang_server::information); // 后去用户信息请求，例如用户的分数、id等
+        }
+        else if (method == "GET" && url == "/stats")
+        {
+            return stats(conn); // 获取服务器运行统计信息
         }
         else
         {
-            return default_page(conn); // 默认页面，即登录页面
+            return default_page(conn, url); // 静态资源，默认为登录页面
         }
     }
 
@@ -270,21 +439,23 @@ private:
         {
             return;
         }
-        // 判断是否重复登录
-        if (_online_manager.is_in_game_hall(ssp->get_user_id()) || _online_manager.is_in_game_room(ssp->get_user_id()))
+        // 将登录用户添加进管理用户模块，已经在线则为重复登录
+        if (_online_manager.login_game_hall(ssp->get_user_id(), conn) == false)
         {
             response["optype"] = "hall_ready";
             response["result"] = false;
             response["reason"] = "重复登录";
             return server_response(conn, response);
         }
-        // 将登录用户添加进管理用户模块
-        _online_manager.login_game_hall(ssp->get_user_id(), conn);
+        // 身份验证通过，填好连接上下文，之后的消息和关闭直接使用
+        conn->kind = CONN_HALL;
+        conn->ssp = ssp;
+        conn->uid = ssp->get_user_id();
         response["optype"] = "hall_ready";
         response["result"] = true;
         server_response(conn, response);
         // 设置session为有限的时间
-        _session_manager.set_session_expire_time(ssp->get_user_id(), SESSION_TIMEOUT);
+        _session_manager.set_session_expire_time(ssp->get_sesssion_id(), SESSION_TIMEOUT);
         // DLOG("退出open_game_hall函数");
         // DLOG("----------------------------------------------------------------------------------------------------");
         return;
@@ -302,39 +473,51 @@ private:
             return;
         }
 
-        // 2.判断当前用户是否重复登录
-        if (_online_manager.is_in_game_hall(ssp->get_user_id()) || _online_manager.is_in_game_room(ssp->get_user_id()))
+        // 2.判断有没有为该用户创建房间
+        room_ptr rm = _room_manager.get_room_by_user_id(ssp->get_user_id());
+        if (rm.get() == nullptr)
         {
             response["optype"] = "room_ready";
             response["result"] = false;
-            response["reason"] = "重复登录";
+            response["reason"] = "没有找到房间信息";
             return server_response(conn, response);
         }
 
-        // 3.判断有没有为该用户创建房间
-        room_ptr rm = _room_manager.get_room_by_user_id(ssp->get_user_id());
-        if (rm.get() == nullptr)
+        // 3.将玩家添加进房间，已经在大厅或房间中则为重复登录
+        if (_online_manager.login_game_room(ssp->get_user_id(), conn, rm->get_room_id()) == false)
         {
             response["optype"] = "room_ready";
             response["result"] = false;
-            response["reason"] = "没有找到房间信息";
+            response["reason"] = "重复登录";
             return server_response(conn, response);
         }
 
-        // 4.将玩家添加进房间
-        _online_manager.login_game_room(ssp->get_user_id(), conn);
+        // 4.填好连接上下文，之后的消息和关闭直接使用，不再查找session和房间
+        conn->kind = CONN_ROOM;
+        conn->ssp = ssp;
+        conn->uid = ssp->get_user_id();
+        conn->rp = rm;
 
         // 5.设置session时间为永久
-        _session_manager.set_session_expire_time(ssp->get_user_id(), SESSION_FOREVER);
+        _session_manager.set_session_expire_time(ssp->get_sesssion_id(), SESSION_FOREVER);
         response["optype"] = "room_ready";
         response["result"] = true;
         response["room_id"] = (Json::UInt64)rm->get_room_id();
         response["uid"] = (Json::UInt64)ssp->get_user_id();
         response["white_id"] = (Json::UInt64)rm->get_white_id();
         response["black_id"] = (Json::UInt64)rm->get_black_id();
+        response["variant"] = VARIANT_NAME[rm->get_variant()];
+        response["board_size"] = rm->get_board_size();
+        // 6.轮到谁下棋要读棋盘，放到房间的strand上和下棋请求排队
+        //   如果机器人先手，在玩家收到房间信息后再让机器人开始思考
+        rm->post([this, rm, conn, response]() mutable
+                 {
+                     response["next_uid"] = (Json::UInt64)rm->get_next_uid();
+                     server_response(conn, response);
+                     rm->bot_turn(); });
         // DLOG("退出open_game_room函数");
         // DLOG("----------------------------------------------------------------------------------------------------");
-        return server_response(conn, response);
+        return;
     }
 
     void handler_open(websocketpp::connection_hdl hdl)
@@ -342,8 +525,7 @@ private:
         // DLOG("----------------------------------------------------------------------------------------------------");
         // DLOG("进入handler_open函数");
         server_t::connection_ptr conn = _server.get_con_from_hdl(hdl);
-        websocketpp::http::parser::request request = conn->get_request();
-        std::string url = request.get_uri();
+        const std::string &url = conn->get_resource(); // 只在open时看一次请求路径，不复制整个请求
         if (url == "/hall")
         {
             return open_game_hall(conn);
@@ -362,43 +544,44 @@ private:
     void close_game_hall(server_t::connection_ptr &conn)
     {
         // 将用户从大厅中移除
-        session_ptr ssp = get_session_by_cookie(conn);
-        if (ssp.get() == nullptr)
+        // 被判为重复登录的连接不在在线表中，断开时不影响已登录的连接
+        if (_online_manager.exit_game_hall(conn->uid, conn) == false)
         {
             return;
         }
-        _online_manager.exit_game_hall(ssp->get_user_id());
         // 设置session时间
-        _session_manager.set_session_expire_time(ssp->get_user_id(), SESSION_TIMEOUT);
+        _session_manager.set_session_expire_time(conn->ssp->get_sesssion_id(), SESSION_TIMEOUT);
     }
 
     void close_game_room(server_t::connection_ptr &conn)
     {
-        session_ptr ssp = get_session_by_cookie(conn);
-        if (ssp.get() == nullptr)
+        uint64_t room_id = 0;
+        if (_online_manager.exit_game_room(conn->uid, conn, room_id) == false)
         {
             return;
         }
-        _online_manager.exit_game_room(ssp->get_user_id());
-        _session_manager.set_session_expire_time(ssp->get_user_id(), SESSION_TIMEOUT);
-        _room_manager.remove_user(ssp->get_user_id());
+        _session_manager.set_session_expire_time(conn->ssp->get_sesssion_id(), SESSION_TIMEOUT);
+        _room_manager.remove_user(conn->uid, room_id);
     }
 
     void handler_close(websocketpp::connection_hdl hdl)
     {
         // DLOG("----------------------------------------------------------------------------------------------------");
         // DLOG("进入handler_close函数");
+        // 没有通过身份验证的连接(包括重复登录)上下文为CONN_HTTP，关闭时什么都不做
         server_t::connection_ptr conn = _server.get_con_from_hdl(hdl);
-        websocketpp::http::parser::request request = conn->get_request();
-        std::string url = request.get_uri();
-        if (url == "/hall")
+        if (conn->kind == CONN_HALL)
         {
-            return close_game_hall(conn);
+            close_game_hall(conn);
         }
-        else if (url == "/room")
+        else if (conn->kind == CONN_ROOM)
         {
-            return close_game_room(conn);
+            close_game_room(conn);
         }
+        // 释放上下文持有的session和房间
+        conn->kind = CONN_HTTP;
+        conn->ssp.reset();
+        conn->rp.reset();
         // DLOG("退出handler_close函数");
         // DLOG("----------------------------------------------------------------------------------------------------");
     }
@@ -408,15 +591,10 @@ private:
     void message_game_hall(server_t::connection_ptr &conn, server_t::message_ptr &message)
     {
         Json::Value response; // 需要返回的json数据
-        std::string resquest_body;
-        // 1.身份验证，判断当前客户端是那个玩家
-        session_ptr ssp = get_session_by_cookie(conn);
-        if (ssp.get() == nullptr)
-        {
-            return;
-        }
+        // 1.身份在open时已经验证过，当前客户端是哪个玩家记录在连接上下文中
+        uint64_t uid = conn->uid;
         // 2.获取请求信息
-        resquest_body = message->get_payload();
+        const std::string &resquest_body = message->get_payload();
         // std::cout << "!!!!!resquest_body : " << resquest_body << std::endl;
         bool ret = json_util::unserialize(resquest_body, response);
         if (ret == false)
@@ -427,17 +605,50 @@ private:
         }
         if (!response["optype"].isNull() && response["optype"].asString() == "match_start")
         {
-            // 开始匹配对战
+            // 开始匹配对战，查询分数可能访问数据库，交给阻塞任务线程池，完成后回到io线程响应
             // DLOG("开始匹配对战");
-            _matcher.add(ssp->get_user_id());
-            response["optype"] = "match_start";
-            response["result"] = true;
-            return server_response(conn, response);
+            // 请求中可以带variant选择对局变体，不带时为标准规则
+            game_variant variant = VARIANT_STANDARD_15;
+            if (response["variant"].isString() && variant_from_name(response["variant"].asString(), variant) == false)
+            {
+                response["optype"] = "match_start";
+                response["result"] = false;
+                response["reason"] = "未知的对局变体";
+                return server_response(conn, response);
+            }
+            uint64_t ticket = _matcher.begin_add(uid);
+            bool posted = _db_worker.post([this, conn, uid, ticket, variant]() mutable
+                                          {
+                                              match_add_result ret = _matcher.add(uid, ticket, variant);
+                                              if (ret == MATCH_CANCELLED) // 已经取消，取消的响应已经发出
+                                              {
+                                                  return;
+                                              }
+                                              Json::Value response;
+                                              response["optype"] = "match_start";
+                                              response["variant"] = VARIANT_NAME[variant];
+                                              response["result"] = ret == MATCH_ADDED;
+                                              if (ret == MATCH_FAILED)
+                                              {
+                                                  response["reason"] = "获取用户信息失败";
+                                              }
+                                              _io_service.post([this, conn, response]() mutable
+                                                               { server_response(conn, response); });
+                                          });
+            if (posted == false)
+            {
+                _matcher.del(uid);
+                response["optype"] = "match_start";
+                response["result"] = false;
+                response["reason"] = "服务器繁忙，请稍后再试";
+                return server_response(conn, response);
+            }
+            return;
         }
         else if (!response["optype"].isNull() && response["optype"].asString() == "match_stop")
         {
             // 停止匹配对战
-            _matcher.del(ssp->get_user_id());
+            _matcher.del(uid);
             response["optype"] = "match_stop";
             response["result"] = true;
             return server_response(conn, response);
@@ -452,15 +663,8 @@ private:
     {
         Json::Value response;
 
-        // 1.检查身份信息
-        session_ptr ssp = get_session_by_cookie(conn);
-        if (ssp.get() == nullptr)
-        {
-            DLOG("房间-没有找到会话信息");
-            return;
-        }
-        // 获取客户端房间信息
-        room_ptr rp = _room_manager.get_room_by_user_id(ssp->get_user_id());
+        // 1.身份和房间在open时已经确定，直接从连接上下文中取
+        room_ptr &rp = conn->rp;
         if (rp.get() == nullptr)
         {
             response["optype"] = "unknow";
@@ -470,8 +674,7 @@ private:
             return server_response(conn, response);
         }
         // 获取消息内容并进行反序列化
-        std::string resquest_body;
-        resquest_body = message->get_payload();
+        const std::string &resquest_body = message->get_payload();
         bool ret = json_util::unserialize(resquest_body, response);
         if (ret == false)
         {
@@ -483,21 +686,20 @@ private:
         }
         // 处理房间动作
         DLOG("房间-动作");
-        return rp->handle_request(response);
+        return rp->post(std::bind(&room::handle_request, rp, response));
     }
 
     void handler_message(websocketpp::connection_hdl hdl, server_t::message_ptr message)
     {
         // DLOG("----------------------------------------------------------------------------------------------------");
         // DLOG("进入handler_message函数");
+        // 连接类型在open时已经确定，没有通过身份验证的连接发来的消息直接丢弃
         server_t::connection_ptr conn = _server.get_con_from_hdl(hdl);
-        websocketpp::http::parser::request request = conn->get_request();
-        std::string url = request.get_uri();
-        if (url == "/hall")
+        if (conn->kind == CONN_HALL)
         {
             return message_game_hall(conn, message);
         }
-        else if (url == "/room")
+        else if (conn->kind == CONN_ROOM)
         {
             return message_game_room(conn, message);
         }
@@ -506,27 +708,16 @@ private:
         return;
     }
 
-    // 从cookie信息中提取session的id
-    bool get_cookie_val(const std::string &cookie_str, const std::string &key, std::string &val)
+    // 从cookie信息中提取session的id，Cookie:SSID=XXX;path=/;
+    // 只在原字符串上移动位置，不分割出新的字符串
+    bool get_cookie_ssid(const std::string &cookie_str, uint64_t &ssid)
     {
-        // Cookie:SSID=XXX;path=/;
-        std::vector<std::string> cookie_arr;
-        string_util::split(cookie_str, ";", cookie_arr);
-        for (auto &tmp : cookie_arr)
-        {
-            std::vector<std::string> ssd_arr;
-            size_t ret = string_util::split(tmp, "=", ssd_arr);
-            if (ret != 2)
-            {
-                continue;
-            }
-            if (ssd_arr[0] == key)
-            {
-                val = ssd_arr[1];
-                return true;
-            }
+        str_view val;
+        if (string_util::cookie_value(cookie_str, "SSID", val) == false)
+        {
+            return false;
         }
-        return false;
+        return string_util::to_uint64(val, ssid);
     }
 
     // 将json结构化数据发送给客户端
@@ -542,7 +733,7 @@ private:
     {
         Json::Value err_response; // 用于返回错误信息
         // 1.查找cookie信息
-        std::string cookie_str = conn->get_request_header("Cookie");
+        const std::string &cookie_str = conn->get_request_header("Cookie");
         if (cookie_str.empty() == true)
         {
             err_response["optype"] = "hall_ready";
@@ -552,8 +743,8 @@ private:
             return session_ptr();
         }
         // 从cookie信息中找到session
-        std::string ssid_str;
-        if (get_cookie_val(cookie_str, "SSID", ssid_str) == false)
+        uint64_t ssid = 0;
+        if (get_cookie_ssid(cookie_str, ssid) == false)
         {
             err_response["optype"] = "hall_ready";
             err_response["result"] = false;
@@ -562,7 +753,7 @@ private:
             return session_ptr();
         }
         // 在session管理中查找对应的会话信息
-        session_ptr ssp = _session_manager.get_session_by_id(std::stol(ssid_str));
+        session_ptr ssp = _session_manager.get_session_by_id(ssid);
         if (ssp.get() == nullptr)
         {
             err_response["optype"] = "hall_ready";
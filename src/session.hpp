@@ -2,9 +2,10 @@
 #pragma once
 
 #include <mutex>
-#include <unordered_map>
 #include <memory>
 #include "util.hpp"
+#include "slot_map.hpp"
+#include "pool.hpp"
 
 // session状态
 typedef enum status
@@ -78,22 +79,35 @@ public:
 
 #define SESSION_TIMEOUT 300000 // session定时销毁的时间
 #define SESSION_FOREVER -1
+#define SESSION_POOL_RESERVE 1024 // 启动时预先分配的session个数，按/stats中session池的峰值调整
 
 typedef std::shared_ptr<session> session_ptr;
 
 // session管理类
+// session存放在槽位表中，session id就是槽位表的id，按id查找是一次带代数校验的数组访问，过期的id不会找到复用槽位的新session
 class session_manager
 {
 private:
-    uint64_t _next_ssid; // 给session分配的id
     std::mutex _mutex;
-    std::unordered_map<uint64_t, session_ptr> _session; // 存储session id和session对象的映射关系
+    std::mutex _timer_mutex;        // 多个io线程可能同时修改同一个session的定时器，串行化定时器的设置
+    slot_map<session_ptr> _session; // 存储session id和session对象的映射关系
     server_t *_server;
 
+    // 定时器到期销毁session，定时器被取消时回调也会执行，此时ec不为空，什么都不做
+    void expire_session(const uint64_t sid, const websocketpp::lib::error_code &ec)
+    {
+        if (ec)
+        {
+            return;
+        }
+        remove_session(sid);
+    }
+
 public:
     session_manager(server_t *server)
-        : _next_ssid(1), _server(server)
+        : _server(server)
     {
+        pool_of<session>().reserve(SESSION_POOL_RESERVE);
         DLOG("session管理模块初始化完成");
     }
 
@@ -102,40 +116,36 @@ public:
         DLOG("session管理模块销毁完毕");
     }
 
-    // 创建session
+    // 创建session，先占用槽位得到session id，再把session放进去
     session_ptr create_session(uint64_t &uid, const session_status &status)
     {
         std::unique_lock<std::mutex> lock(_mutex);
-        session_ptr sp(new session(_next_ssid));
+        uint64_t ssid = _session.insert(session_ptr());
+        if (ssid == 0)
+        {
+            return session_ptr();
+        }
+        session_ptr sp = std::allocate_shared<session>(pool_allocator<session>(), ssid);
         sp->set_uid(uid);
         sp->set_status(status);
-        _session.insert(std::make_pair(_next_ssid, sp));
-        _next_ssid++;
+        *_session.find(ssid) = sp;
         return sp;
     }
 
-    // 重新添加session
-    void append_session(const session_ptr &sp)
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _session.insert(std::make_pair(sp->get_sesssion_id(), sp));
-        return;
-    }
-
     // 通过session id获取session
     session_ptr get_session_by_id(const uint64_t &sid)
     {
         std::unique_lock<std::mutex> lock(_mutex);
-        auto it = _session.find(sid);
-        if (it == _session.end())
+        session_ptr *sp = _session.find(sid);
+        if (sp == nullptr)
         {
             return session_ptr();
         }
-        return it->second;
+        return *sp;
     }
 
     // 销毁session
-    void remove_session(uint64_t &sid)
+    void remove_session(const uint64_t &sid)
     {
         std::unique_lock<std::mutex> lock(_mutex);
         _session.erase(sid);
@@ -145,6 +155,7 @@ public:
     // 设置session生命周期
     void set_session_expire_time(uint64_t sid, const int ms)
     {
+        std::unique_lock<std::mutex> timer_lock(_timer_mutex);
         // 先查找要设置的session是否存在
         session_ptr sp = get_session_by_id(sid);
         if (sp == nullptr)
@@ -153,34 +164,29 @@ public:
         }
         // 获取定时器
         server_t::timer_ptr tp = sp->get_timer();
-        // 1.没有定时器，且session的生命周期为永久，则什么都不干
-        // 2.没有定时器，且session的生命周期存在，则设置一个新的定时器，，，这个时候用户处于 刚登陆状态
-        // 3.有定时器，且session的生命周期为永久，重置定时器为永久，，，这个时候用户处于 房间对战状态
-        // 4.有定时器，且session的生命周期存在，重置定时器时间，，，这个时候用户处于 刚对战完返回大厅状态
-        if (tp.get() == nullptr && ms == SESSION_FOREVER)
-        {
-            return;
-        }
-        else if (tp.get() == nullptr && ms != SESSION_FOREVER)
-        {
-            server_t::timer_ptr tmp_tp = _server->set_timer(ms, std::bind(&session_manager::remove_session, this, sid));
-            sp->set_timer(tmp_tp);
-        }
-        else if (tp.get() != nullptr && ms == SESSION_FOREVER)
-        {
-            tp->cancel();                         // 取消定时器，但是取消定时器后，定时的任务就会被执行，但是这个定时任务并不是立即执行的
-            sp->set_timer(server_t::timer_ptr()); // 所以要先给对于的session对象的定时器对象置为nullptr
-            _server->set_timer(0, std::bind(&session_manager::append_session, this, sp));
-        }
-        else if (tp.get() != nullptr && ms != SESSION_FOREVER)
+        // 1.有定时器，先取消，取消后的回调不会销毁session
+        // 2.session的生命周期为永久，不再设置定时器，，，这个时候用户处于 房间对战状态
+        // 3.session的生命周期存在，设置一个新的定时器，，，这个时候用户处于 刚登陆状态 或 刚对战完返回大厅状态
+        if (tp.get() != nullptr)
         {
             tp->cancel();
             sp->set_timer(server_t::timer_ptr());
-            _server->set_timer(0, std::bind(&session_manager::append_session, this, sp));
-            // 重新设置时间
-            server_t::timer_ptr tmp_tp = _server->set_timer(ms, std::bind(&session_manager::remove_session, this, sid));
-            sp->set_timer(tmp_tp);
         }
+        if (ms == SESSION_FOREVER)
+        {
+            return;
+        }
+        server_t::timer_ptr tmp_tp = _server->set_timer(ms, std::bind(&session_manager::expire_session, this, sid,
+                                                                      std::placeholders::_1));
+        sp->set_timer(tmp_tp);
         return;
     }
-};
\ No newline at end of file
+
+    // 获取session数和槽位数
+    void stats(uint64_t &sessions, uint64_t &slots)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        sessions = _session.size();
+        slots = _session.capacity();
+    }
+};
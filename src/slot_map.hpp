@@ -0,0 +1,118 @@
+// 槽位表模块，房间和session按id存取时用数组下标代替哈希查找
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define SLOT_INDEX_BITS 24      // id的低24位为槽位下标
+#define SLOT_GENERATION_BITS 29 // 往上29位为代数，id总共53位，前端js可以精确表示
+
+// 带代数的槽位表：元素连续存放在数组中，id = 代数 << SLOT_INDEX_BITS | 下标
+// 删除元素时槽位的代数加一，槽位复用后旧id的代数对不上，查找返回空，不会取到别的对象
+// 不加锁，由使用者加锁
+template <class T>
+class slot_map
+{
+private:
+    struct slot
+    {
+        T value;
+        uint32_t generation; // 当前代数，从1开始，所以id不会为0
+        uint32_t next_free;  // 空闲时指向下一个空闲槽位
+        bool used;
+    };
+    std::vector<slot> _slots;
+    uint32_t _free_head; // 空闲链表头，没有空闲槽位时为NONE
+    size_t _size;        // 使用中的槽位数
+
+    static const uint32_t NONE = (uint32_t)-1;
+    static const uint64_t INDEX_MASK = ((uint64_t)1 << SLOT_INDEX_BITS) - 1;
+    static const uint32_t GENERATION_MASK = ((uint32_t)1 << SLOT_GENERATION_BITS) - 1;
+
+    static uint32_t index_of(const uint64_t id)
+    {
+        return (uint32_t)(id & INDEX_MASK);
+    }
+
+    static uint32_t generation_of(const uint64_t id)
+    {
+        return (uint32_t)(id >> SLOT_INDEX_BITS);
+    }
+
+public:
+    slot_map()
+        : _free_head(NONE), _size(0)
+    {
+    }
+
+    // 插入元素，返回它的id，槽位用完时返回0
+    uint64_t insert(const T &value)
+    {
+        uint32_t index = _free_head;
+        if (index != NONE)
+        {
+            _free_head = _slots[index].next_free;
+        }
+        else
+        {
+            if (_slots.size() > INDEX_MASK)
+            {
+                return 0;
+            }
+            index = (uint32_t)_slots.size();
+            _slots.push_back(slot{T(), 1, NONE, false});
+        }
+        slot &s = _slots[index];
+        s.value = value;
+        s.used = true;
+        _size++;
+        return ((uint64_t)s.generation << SLOT_INDEX_BITS) | index;
+    }
+
+    // 查找元素，id不存在或者已经过期返回nullptr
+    T *find(const uint64_t id)
+    {
+        uint32_t index = index_of(id);
+        if (index >= _slots.size())
+        {
+            return nullptr;
+        }
+        slot &s = _slots[index];
+        if (s.used == false || s.generation != generation_of(id))
+        {
+            return nullptr;
+        }
+        return &s.value;
+    }
+
+    // 删除元素，槽位的代数加一后放回空闲链表
+    bool erase(const uint64_t id)
+    {
+        if (find(id) == nullptr)
+        {
+            return false;
+        }
+        uint32_t index = index_of(id);
+        slot &s = _slots[index];
+        s.value = T(); // 立刻释放元素持有的资源
+        s.used = false;
+        s.generation = s.generation == GENERATION_MASK ? 1 : s.generation + 1; // 代数回绕时跳过0
+        s.next_free = _free_head;
+        _free_head = index;
+        _size--;
+        return true;
+    }
+
+    // 使用中的元素个数
+    size_t size() const
+    {
+        return _size;
+    }
+
+    // 已经分配的槽位个数
+    size_t capacity() const
+    {
+        return _slots.size();
+    }
+};
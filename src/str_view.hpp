@@ -0,0 +1,233 @@
+// 字符串视图模块，解析cookie、查询串和路径时只记录位置和长度，不复制字符串，不申请内存
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// 指向一段已有字符的只读视图，不拥有内存，被指向的字符串必须比视图活得久
+struct str_view
+{
+    static const size_t npos = (size_t)-1;
+
+    const char *data;
+    size_t size;
+
+    str_view()
+        : data(""), size(0)
+    {
+    }
+
+    str_view(const char *str, const size_t len)
+        : data(str), size(len)
+    {
+    }
+
+    str_view(const char *str)
+        : data(str), size(strlen(str))
+    {
+    }
+
+    str_view(const std::string &str)
+        : data(str.data()), size(str.size())
+    {
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    char operator[](const size_t i) const
+    {
+        return data[i];
+    }
+
+    bool operator==(const str_view &other) const
+    {
+        return size == other.size && memcmp(data, other.data, size) == 0;
+    }
+
+    bool operator!=(const str_view &other) const
+    {
+        return !(*this == other);
+    }
+
+    // 从pos开始查找字符c，找不到返回npos
+    size_t find(const char c, const size_t pos = 0) const
+    {
+        if (pos >= size)
+        {
+            return npos;
+        }
+        const void *p = memchr(data + pos, c, size - pos);
+        return p == nullptr ? npos : (const char *)p - data;
+    }
+
+    // 从pos开始、长度最多为len的子视图
+    str_view substr(const size_t pos, const size_t len = npos) const
+    {
+        if (pos >= size)
+        {
+            return str_view(data + size, 0);
+        }
+        return str_view(data + pos, len < size - pos ? len : size - pos);
+    }
+
+    // 去掉首尾的空格和制表符
+    str_view trim() const
+    {
+        size_t left = 0, right = size;
+        while (left < right && (data[left] == ' ' || data[left] == '\t'))
+        {
+            left++;
+        }
+        while (right > left && (data[right - 1] == ' ' || data[right - 1] == '\t'))
+        {
+            right--;
+        }
+        return str_view(data + left, right - left);
+    }
+
+    // 需要保存时才复制成std::string
+    std::string str() const
+    {
+        return std::string(data, size);
+    }
+};
+
+// 封装字符串处理功能类
+class string_util
+{
+public:
+    // 进行字符串分割处理
+    static size_t split(const std::string &src, const std::string &sep, std::vector<std::string> &res)
+    {
+        //"123,456,,,789"
+        size_t left = 0, right = 0;
+        while (right < src.size())
+        {
+            right = src.find(sep, right);
+            if (right == std::string::npos)
+            {
+                res.push_back(src.substr(left, right));
+                break;
+            }
+            //",123,456"    //处理特殊情况
+            if (left == right)
+            {
+                right += sep.size();
+                left = right;
+                continue;
+            }
+            res.push_back(src.substr(left, right - left));
+            right += sep.size();
+            left = right;
+        }
+        return res.size();
+    }
+
+    // 从rest中取出下一个以sep分隔的片段，rest前移到片段之后，rest已经为空时返回false
+    static bool next_token(str_view &rest, const char sep, str_view &token)
+    {
+        if (rest.empty())
+        {
+            return false;
+        }
+        size_t pos = rest.find(sep);
+        if (pos == str_view::npos)
+        {
+            token = rest;
+            rest = rest.substr(rest.size);
+            return true;
+        }
+        token = rest.substr(0, pos);
+        rest = rest.substr(pos + 1);
+        return true;
+    }
+
+    // 在"k1=v1<sep>k2=v2"形式的串中查找key对应的值，键和值的首尾空白会被去掉
+    static bool find_pair(str_view rest, const char sep, const str_view &key, str_view &val)
+    {
+        str_view token;
+        while (next_token(rest, sep, token))
+        {
+            size_t eq = token.find('=');
+            if (eq == str_view::npos)
+            {
+                continue;
+            }
+            if (token.substr(0, eq).trim() == key)
+            {
+                val = token.substr(eq + 1).trim();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 从Cookie头中取出key的值，例如 Cookie: SSID=XXX; path=/
+    static bool cookie_value(const str_view &cookie, const str_view &key, str_view &val)
+    {
+        return find_pair(cookie, ';', key, val);
+    }
+
+    // 从查询串中取出key的值，例如 a=1&b=2，不做百分号解码
+    static bool query_value(const str_view &query, const str_view &key, str_view &val)
+    {
+        return find_pair(query, '&', key, val);
+    }
+
+    // uri中'?'之前的路径部分
+    static str_view uri_path(const str_view &uri)
+    {
+        return uri.substr(0, uri.find('?'));
+    }
+
+    // uri中'?'之后的查询串，没有查询串时为空
+    static str_view uri_query(const str_view &uri)
+    {
+        size_t pos = uri.find('?');
+        return pos == str_view::npos ? str_view() : uri.substr(pos + 1);
+    }
+
+    // 依次取出路径中的各段，跳过连续的'/'，例如 /a//b/ 取出 a 和 b
+    static bool next_segment(str_view &rest, str_view &segment)
+    {
+        while (next_token(rest, '/', segment))
+        {
+            if (segment.empty() == false)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 把十进制数字串转换为uint64_t，有非数字字符、为空或者溢出时返回false
+    static bool to_uint64(const str_view &str, uint64_t &value)
+    {
+        if (str.empty())
+        {
+            return false;
+        }
+        uint64_t result = 0;
+        for (size_t i = 0; i < str.size; i++)
+        {
+            if (str[i] < '0' || str[i] > '9')
+            {
+                return false;
+            }
+            uint64_t digit = str[i] - '0';
+            if (result > (UINT64_MAX - digit) / 10)
+            {
+                return false;
+            }
+            result = result * 10 + digit;
+        }
+        value = result;
+        return true;
+    }
+};
@@ -0,0 +1,452 @@
+// 算杀模块，连续冲四(VCF)和连续冲四活三(VCT)的威胁空间搜索
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include "board.hpp"
+#include "pattern.hpp"
+
+#define THREAT_MEMO_BITS 16      // 算杀记忆表大小为2^16项
+#define THREAT_MAX_NODES 100000  // 一次算杀最多搜索的节点数，超过后放弃，保证毫秒级返回
+#define VCF_MAX_DEPTH 12         // 连续冲四最多的进攻步数
+#define VCT_MAX_DEPTH 4          // 连续冲四活三最多的进攻步数
+
+// 算杀结果
+struct threat_result
+{
+    bool win;       // 是否找到必胜的连续进攻
+    int row;        // 第一步进攻的位置
+    int col;
+    int depth;      // 进攻方需要的步数
+    uint64_t nodes; // 搜索的节点数
+};
+
+// 算杀记忆表，按局面键值记录已经证明的胜负，不占用搜索引擎的置换表和局面缓存
+// 每个线程一张，同一线程先后创建的求解器重复使用；每个求解器开始时代数加1，其他代的项当作空项，不需要清空1MB
+class threat_memo
+{
+public:
+    struct entry
+    {
+        uint64_t key;        // 局面键值^进攻方^模式
+        int8_t depth;        // 证明时的剩余步数
+        int8_t win;          // 1表示能杀，0表示在depth步内杀不了
+        int16_t move;        // 能杀时的第一步，row * BOARD_COL + col
+        uint32_t generation; // 记录时的代数，0表示空
+    };
+
+private:
+    std::vector<entry> _table;
+    uint64_t _mask;
+    uint32_t _generation;
+
+    threat_memo(const int bits = THREAT_MEMO_BITS)
+        : _table((size_t)1 << bits, entry{0, 0, 0, 0, 0}), _mask(((uint64_t)1 << bits) - 1), _generation(0)
+    {
+    }
+
+public:
+    // 当前线程的记忆表，第一次使用时创建
+    static threat_memo &local()
+    {
+        thread_local threat_memo memo;
+        return memo;
+    }
+
+    // 开始一个新的求解器，之前的项全部作废，代数用完一轮时才真正清空
+    void next()
+    {
+        if (++_generation == 0)
+        {
+            std::fill(_table.begin(), _table.end(), entry{0, 0, 0, 0, 0});
+            _generation = 1;
+        }
+    }
+
+    // 查找键值，不是当前代记录的返回nullptr
+    const entry *find(const uint64_t key) const
+    {
+        const entry &e = _table[key & _mask];
+        return e.generation == _generation && e.key == key ? &e : nullptr;
+    }
+
+    void store(const uint64_t key, const int depth, const bool win, const int move)
+    {
+        entry &e = _table[key & _mask];
+        e.key = key;
+        e.depth = (int8_t)depth;
+        e.win = win ? 1 : 0;
+        e.move = (int16_t)move;
+        e.generation = _generation;
+    }
+};
+
+// 威胁空间搜索：进攻方只走冲四(VCT还走活三)，防守方只走能挡住威胁的点和自己的冲四
+// 深度优先加迭代加深，先找到的就是步数最少的杀法
+// 记忆表是所在线程的threat_memo，同一线程同一时间只能有一个求解器
+class threat_solver
+{
+private:
+    bit_board _board;
+    threat_memo &_memo;
+    uint64_t _nodes;   // 已搜索的节点数
+    uint64_t _limit;   // 节点数上限
+    bool _aborted;     // 是否因为节点数超限放弃，放弃时不记录失败结果
+
+public:
+    threat_solver(const bit_board &board, const uint64_t limit = THREAT_MAX_NODES)
+        : _board(board), _memo(threat_memo::local()), _nodes(0), _limit(limit), _aborted(false)
+    {
+        _memo.next();
+    }
+
+    // 轮到chess_color下棋，求连续冲四的杀法
+    threat_result vcf(const int chess_color, const int max_depth = VCF_MAX_DEPTH)
+    {
+        return solve(chess_color, max_depth, false);
+    }
+
+    // 轮到chess_color下棋，求连续冲四活三的杀法
+    threat_result vct(const int chess_color, const int max_depth = VCT_MAX_DEPTH)
+    {
+        return solve(chess_color, max_depth, true);
+    }
+
+    // 轮到chess_color下棋，判断在空位(row, col)落子后是否仍然有连续冲四的杀法，即这一手是否是某个杀法的第一步
+    // 杀法的第一步往往不止一个，复盘时用它确认玩家的落子确实错过了杀棋；节点数超限无法判断时当作仍然能杀
+    bool vcf_move(const int chess_color, const int row, const int col, const int max_depth = VCF_MAX_DEPTH)
+    {
+        _nodes = 0;
+        _aborted = false;
+        if (makes_five(chess_color, row, col))
+        {
+            return true;
+        }
+        int threat = find_five(3 - chess_color);
+        if (threat == -2 || (threat >= 0 && threat != row * BOARD_COL + col)) // 没有挡住守方的成五点
+        {
+            return false;
+        }
+        _board.put(row, col, chess_color);
+        bool won = after_four(chess_color, row, col, max_depth, false);
+        _board.remove(row, col, chess_color);
+        return won || _aborted;
+    }
+
+private:
+    threat_result solve(const int chess_color, const int max_depth, const bool three)
+    {
+        threat_result result = {false, -1, -1, 0, 0};
+        _nodes = 0;
+        _aborted = false;
+        int threat = find_five(3 - chess_color);
+        for (int depth = 1; depth <= max_depth && _aborted == false; depth++)
+        {
+            int move = -1;
+            if (attack(chess_color, depth, three, threat, move))
+            {
+                result.win = true;
+                result.row = move / BOARD_COL;
+                result.col = move % BOARD_COL;
+                result.depth = depth;
+                break;
+            }
+        }
+        result.nodes = _nodes;
+        return result;
+    }
+
+    // 进攻方chess_color走，threat为守方的成五点(-1没有，-2不止一个)，depth为剩余步数
+    // 能在depth步内杀棋返回true，move带回第一步
+    bool attack(const int chess_color, const int depth, const bool three, const int threat, int &move)
+    {
+        if (++_nodes > _limit)
+        {
+            _aborted = true;
+            return false;
+        }
+        uint64_t key = _board.key() ^ (chess_color == WHITE_CHESS ? 0x5BD1E9955BD1E995ULL : 0x2545F4914F6CDD1DULL) ^
+                       (three ? 0x9E3779B97F4A7C15ULL : 0);
+        const threat_memo::entry *e = _memo.find(key);
+        if (e != nullptr && ((e->win && e->depth <= depth) || (!e->win && e->depth >= depth)))
+        {
+            move = e->move;
+            return e->win;
+        }
+
+        std::vector<int> cells;
+        candidates(chess_color, cells);
+        // 1.能直接成五
+        for (int cell : cells)
+        {
+            if (makes_five(chess_color, cell / BOARD_COL, cell % BOARD_COL))
+            {
+                move = cell;
+                return remember(key, depth, true, cell);
+            }
+        }
+        // 2.守方已经有两个成五点，挡不住
+        if (threat == -2)
+        {
+            return remember(key, depth, false, -1);
+        }
+        // 3.先试冲四，再试活三；守方有成五点时只能下在那个点上
+        for (int pass = 0; pass <= (three ? 1 : 0) && _aborted == false; pass++)
+        {
+            for (int cell : cells)
+            {
+                if (threat >= 0 && cell != threat)
+                {
+                    continue;
+                }
+                int row = cell / BOARD_COL, col = cell % BOARD_COL;
+                _board.put(row, col, chess_color);
+                bool won = pass == 0 ? after_four(chess_color, row, col, depth, three)
+                                     : after_three(chess_color, row, col, depth);
+                _board.remove(row, col, chess_color);
+                if (won)
+                {
+                    move = cell;
+                    return remember(key, depth, true, cell);
+                }
+                if (_aborted)
+                {
+                    return false;
+                }
+            }
+        }
+        return remember(key, depth, false, -1);
+    }
+
+    // 进攻方刚在(row, col)落子，如果形成冲四，守方只能挡，挡完后继续进攻
+    bool after_four(const int chess_color, const int row, const int col, const int depth, const bool three)
+    {
+        int points[2];
+        int count = five_points(chess_color, row, col, points);
+        if (count == 0)
+        {
+            return false;
+        }
+        if (count >= 2) // 活四或者双四，守方只能挡一个
+        {
+            return true;
+        }
+        if (depth <= 1)
+        {
+            return false;
+        }
+        int opp = 3 - chess_color;
+        int br = points[0] / BOARD_COL, bc = points[0] % BOARD_COL;
+        _board.put(br, bc, opp);
+        int move = -1;
+        bool won = attack(chess_color, depth - 1, three, threat_after(opp, br, bc), move);
+        _board.remove(br, bc, opp);
+        return won;
+    }
+
+    // 进攻方刚在(row, col)落子，如果形成活三(且不是冲四)，守方的每一种防守都要能继续杀
+    bool after_three(const int chess_color, const int row, const int col, const int depth)
+    {
+        if (depth <= 1 || five_points(chess_color, row, col, nullptr) != 0)
+        {
+            return false;
+        }
+        int opp = 3 - chess_color;
+        std::vector<int> defends;
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            board_dir dir = (board_dir)d;
+            int index = bit_board::line_index(row, col, dir);
+            int pos = bit_board::line_pos(row, col, dir);
+            uint32_t own = _board.line_bits(chess_color, dir, index);
+            uint32_t space = bit_board::line_mask(dir, index) & ~own & ~_board.line_bits(opp, dir, index);
+            if (line_threat::four_points(own, space, pos) == 0)
+            {
+                continue;
+            }
+            // 守方下在这条线上某个空位后，进攻方不能再形成活四，这个空位就是防守点
+            for (uint32_t rest = space & line_threat::near(pos); rest != 0; rest &= rest - 1)
+            {
+                int e = __builtin_ctz(rest);
+                if (line_threat::four_points(own, space & ~(1u << e), pos) == 0)
+                {
+                    int r = row, c = col;
+                    line_step(dir, e - pos, r, c);
+                    defends.push_back(r * BOARD_COL + c);
+                }
+            }
+        }
+        if (defends.empty())
+        {
+            return false;
+        }
+        // 守方也可以用冲四反击
+        std::vector<int> cells;
+        candidates(opp, cells);
+        for (int cell : cells)
+        {
+            int r = cell / BOARD_COL, c = cell % BOARD_COL;
+            _board.put(r, c, opp);
+            if (five_points(opp, r, c, nullptr) != 0)
+            {
+                defends.push_back(cell);
+            }
+            _board.remove(r, c, opp);
+        }
+        std::sort(defends.begin(), defends.end()); // 同一个点可能既是防守点又是冲四点
+        defends.erase(std::unique(defends.begin(), defends.end()), defends.end());
+        for (int cell : defends)
+        {
+            int r = cell / BOARD_COL, c = cell % BOARD_COL;
+            _board.put(r, c, opp);
+            int move = -1;
+            bool won = attack(chess_color, depth - 1, true, threat_after(opp, r, c), move);
+            _board.remove(r, c, opp);
+            if (won == false)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 守方刚在(row, col)落子后的成五点，-1没有，-2不止一个
+    int threat_after(const int chess_color, const int row, const int col)
+    {
+        int points[2];
+        int count = five_points(chess_color, row, col, points);
+        return count == 0 ? -1 : (count == 1 ? points[0] : -2);
+    }
+
+    // 经过刚落下的(row, col)的四条线上，chess_color的成五点个数(最多数到2)，points不为空时带回这些点
+    int five_points(const int chess_color, const int row, const int col, int *points)
+    {
+        int count = 0;
+        int first = -1;
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            board_dir dir = (board_dir)d;
+            int index = bit_board::line_index(row, col, dir);
+            int pos = bit_board::line_pos(row, col, dir);
+            uint32_t own = _board.line_bits(chess_color, dir, index);
+            uint32_t space = bit_board::line_mask(dir, index) & ~own & ~_board.line_bits(3 - chess_color, dir, index);
+            for (uint32_t rest = line_threat::five_points(own, space, pos); rest != 0; rest &= rest - 1)
+            {
+                int r = row, c = col;
+                line_step(dir, __builtin_ctz(rest) - pos, r, c);
+                int cell = r * BOARD_COL + c;
+                if (cell == first) // 两条线共用一个成五点
+                {
+                    continue;
+                }
+                if (points != nullptr)
+                {
+                    points[count] = cell;
+                }
+                first = first < 0 ? cell : first;
+                if (++count == 2)
+                {
+                    return count;
+                }
+            }
+        }
+        return count;
+    }
+
+    // 在空位(row, col)落子是否恰好成五
+    bool makes_five(const int chess_color, const int row, const int col) const
+    {
+        for (int d = 0; d < DIR_COUNT; d++)
+        {
+            int pos = 0;
+            uint32_t bits = _board.line(row, col, chess_color, (board_dir)d, pos);
+            if (bit_board::run_at(bits | (1u << pos), pos) == 5)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 整个棋盘上chess_color的成五点，-1没有，-2不止一个，只在求解开始时调用
+    int find_five(const int chess_color)
+    {
+        std::vector<int> cells;
+        candidates(chess_color, cells);
+        int found = -1;
+        for (int cell : cells)
+        {
+            if (makes_five(chess_color, cell / BOARD_COL, cell % BOARD_COL))
+            {
+                if (found >= 0)
+                {
+                    return -2;
+                }
+                found = cell;
+            }
+        }
+        return found;
+    }
+
+    // chess_color的棋子周围两格内的空位，冲四和活三的落子点一定在这个范围内
+    void candidates(const int chess_color, std::vector<int> &cells) const
+    {
+        const uint32_t full = (1u << BOARD_COL) - 1;
+        for (int row = 0; row < BOARD_ROW; row++)
+        {
+            uint32_t near = 0;
+            for (int r = row - 2; r <= row + 2; r++)
+            {
+                if (r >= 0 && r < BOARD_ROW)
+                {
+                    near |= _board.line_bits(chess_color, DIR_ROW, r);
+                }
+            }
+            near = (near | near << 1 | near << 2 | near >> 1 | near >> 2) & full;
+            near &= ~(_board.line_bits(WHITE_CHESS, DIR_ROW, row) | _board.line_bits(BLACK_CHESS, DIR_ROW, row));
+            for (; near != 0; near &= near - 1)
+            {
+                cells.push_back(row * BOARD_COL + __builtin_ctz(near));
+            }
+        }
+        return;
+    }
+
+    // 记录证明结果，因节点数超限放弃的搜索不记录失败
+    bool remember(const uint64_t key, const int depth, const bool win, const int move)
+    {
+        if (win == false && _aborted)
+        {
+            return false;
+        }
+        _memo.store(key, depth, win, move);
+        return win;
+    }
+};
+
+// 复盘：按顺序重放对局，找出chess_color第一次有连续冲四杀法、实际落子却不是任何一个杀法第一步的位置
+// moves为双方依次的落子(row * BOARD_COL + col)，白方先手；找到返回true，step为那一手的序号(从0开始)
+inline bool find_missed_win(const std::vector<int> &moves, const int chess_color, int &step, threat_result &result)
+{
+    bit_board board;
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        int mover = i % 2 == 0 ? WHITE_CHESS : BLACK_CHESS;
+        int row = moves[i] / BOARD_COL, col = moves[i] % BOARD_COL;
+        if (mover == chess_color)
+        {
+            threat_solver solver(board);
+            threat_result threat = solver.vcf(chess_color);
+            if (threat.win && (threat.row != row || threat.col != col) && solver.vcf_move(chess_color, row, col) == false)
+            {
+                step = (int)i;
+                result = threat;
+                return true;
+            }
+        }
+        board.put(row, col, mover);
+    }
+    return false;
+}
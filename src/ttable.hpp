@@ -0,0 +1,88 @@
+// 置换表模块，多个搜索线程共享的无锁置换表
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#define SEARCH_TT_BITS 18 // 置换表大小为2^18项，每项16字节，共4MB
+
+// 置换表中分数的类型
+enum tt_flag
+{
+    TT_EXACT = 0, // 精确值
+    TT_LOWER,     // 下界，发生了beta截断
+    TT_UPPER      // 上界，所有走法都没有超过alpha
+};
+
+// 无锁置换表：每项存 键值^数据 和 数据 两个原子变量
+// 读取时两者异或还原出键值，如果另一个线程写了一半，还原出的键值对不上，这一项就当作没有命中
+// 每个机器人线程的置换表在多次搜索之间重复使用，每次搜索开始时代数加1，其他代的项当作没有命中，不需要清空4MB
+class transposition_table
+{
+private:
+    struct entry
+    {
+        std::atomic<uint64_t> check; // 键值^数据
+        std::atomic<uint64_t> data;  // 分数(32位) | 深度(8位) | 类型(4位) | 最佳走法(12位) | 代数(8位)
+    };
+    std::vector<entry> _table;
+    uint64_t _mask;
+    uint8_t _generation; // 当前搜索的代数，从1开始，数据为0的项是空项
+
+    // 清空所有项
+    void clear()
+    {
+        for (auto &e : _table)
+        {
+            e.check.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    transposition_table(const int bits = SEARCH_TT_BITS)
+        : _table((size_t)1 << bits), _mask(((uint64_t)1 << bits) - 1), _generation(1)
+    {
+        clear();
+    }
+
+    // 开始新的一次搜索，之前的项全部作废，在启动辅助线程之前调用
+    // 代数用完一轮回到1时才真正清空一次，避免255次搜索之前的旧项又被当作命中
+    void new_search()
+    {
+        if (++_generation == 0)
+        {
+            clear();
+            _generation = 1;
+        }
+    }
+
+    // 查找局面，找到返回true，并取出分数、深度、类型和最佳走法(row * BOARD_COL + col，-1表示没有)
+    bool probe(const uint64_t key, int &score, int &depth, tt_flag &flag, int &move) const
+    {
+        const entry &e = _table[key & _mask];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || data == 0 || (data >> 56) != _generation)
+        {
+            return false;
+        }
+        score = (int32_t)(uint32_t)data;
+        depth = (int)((data >> 32) & 0xFF);
+        flag = (tt_flag)((data >> 40) & 0xF);
+        move = (int)((data >> 44) & 0xFFF) - 1;
+        return true;
+    }
+
+    // 保存局面，直接覆盖旧的项，记上当前的代数
+    void store(const uint64_t key, const int score, const int depth, const tt_flag flag, const int move)
+    {
+        entry &e = _table[key & _mask];
+        uint64_t data = (uint64_t)(uint32_t)score | ((uint64_t)depth << 32) |
+                        ((uint64_t)flag << 40) | ((uint64_t)(move + 1) << 44) | ((uint64_t)_generation << 56);
+        e.data.store(data, std::memory_order_relaxed);
+        e.check.store(key ^ data, std::memory_order_relaxed);
+        return;
+    }
+};
@@ -0,0 +1,181 @@
+// 用户信息缓存模块，匹配和查询用户信息时先查缓存，大部分请求不再访问数据库
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "log.hpp"
+
+#define USER_CACHE_SHARDS 16        // 分段数，每段一把锁和一条LRU链表
+#define USER_CACHE_CAPACITY 65536   // 缓存的用户总数上限，平均分给各段
+
+// 缓存的用户信息
+struct user_profile
+{
+    std::string username;
+    int64_t score;
+    int total_count;
+    int win_count;
+};
+
+// 按用户id分段的LRU缓存：每段各自淘汰最久没有用到的用户，不同用户的查询很少互相等待
+// 批量写入对局结果时，提交前把用户标记为更新中，提交后在缓存上直接加上胜负变化并清除标记，玩家回到大厅再匹配时仍然命中
+// 从数据库读出的信息放入缓存前检查段的版本号和更新标记：读取期间开始或结束过更新、或者正在更新时不放入，
+// 读出的数据可能是提交前的，也可能已经包含这次变化，放入后再叠加就会重复计算
+class user_cache
+{
+private:
+    typedef std::list<std::pair<uint64_t, user_profile>> lru_list; // 链表头部是最近用到的用户
+    struct shard
+    {
+        std::mutex mutex;
+        lru_list lru;
+        std::unordered_map<uint64_t, lru_list::iterator> index;
+        std::unordered_map<uint64_t, int> updating; // 正在写入对局结果的用户和进行中的批次数
+        uint64_t version; // 段内每作废一个用户、每开始或结束一次更新加1
+    };
+    shard _shards[USER_CACHE_SHARDS];
+    size_t _shard_capacity;            // 每段最多缓存的用户数
+    std::atomic<uint64_t> _hits;       // 命中次数
+    std::atomic<uint64_t> _misses;     // 未命中次数
+    std::atomic<uint64_t> _evictions;  // 淘汰次数
+
+    shard &get_shard(const uint64_t &id)
+    {
+        return _shards[id % USER_CACHE_SHARDS];
+    }
+
+public:
+    user_cache(const size_t capacity = USER_CACHE_CAPACITY)
+        : _shard_capacity(capacity / USER_CACHE_SHARDS == 0 ? 1 : capacity / USER_CACHE_SHARDS),
+          _hits(0), _misses(0), _evictions(0)
+    {
+        for (auto &s : _shards)
+        {
+            s.version = 0;
+        }
+    }
+
+    // 读取数据库之前取得用户所在段的版本号，之后随信息一起传给put
+    uint64_t version(const uint64_t &id)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        return s.version;
+    }
+
+    // 查找用户，找到时移到链表头部并返回true
+    bool get(const uint64_t &id, user_profile &profile)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        auto it = s.index.find(id);
+        if (it == s.index.end())
+        {
+            _misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        profile = it->second->second;
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 放入或覆盖从数据库读出的用户信息，段的版本号已经变化时不放入，段已满时淘汰链表尾部的用户
+    void put(const uint64_t &id, const user_profile &profile, const uint64_t &version)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        if (s.version != version || s.updating.count(id) != 0)
+        {
+            return;
+        }
+        auto it = s.index.find(id);
+        if (it != s.index.end())
+        {
+            it->second->second = profile;
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            return;
+        }
+        if (s.lru.size() >= _shard_capacity)
+        {
+            s.index.erase(s.lru.back().first);
+            s.lru.pop_back();
+            _evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        s.lru.push_front(std::make_pair(id, profile));
+        s.index[id] = s.lru.begin();
+    }
+
+    // 移除用户，下次查询时重新从数据库读取
+    void erase(const uint64_t &id)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.version++;
+        auto it = s.index.find(id);
+        if (it == s.index.end())
+        {
+            return;
+        }
+        s.lru.erase(it->second);
+        s.index.erase(it);
+    }
+
+    // 在数据库中写入用户的对局结果之前调用，之后必须调用一次end_update
+    void begin_update(const uint64_t &id)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.version++;
+        s.updating[id]++;
+    }
+
+    // 写入结束：提交成功时在缓存的信息上加上变化，失败时不知道写到了哪一步，移除用户
+    void end_update(const uint64_t &id, const bool committed, const int64_t score_delta, const int total_delta,
+                    const int win_delta)
+    {
+        shard &s = get_shard(id);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.version++;
+        auto pit = s.updating.find(id);
+        if (pit != s.updating.end() && --pit->second == 0)
+        {
+            s.updating.erase(pit);
+        }
+        auto it = s.index.find(id);
+        if (it == s.index.end())
+        {
+            return;
+        }
+        if (committed)
+        {
+            user_profile &profile = it->second->second;
+            profile.score += score_delta;
+            profile.total_count += total_delta;
+            profile.win_count += win_delta;
+            return;
+        }
+        s.lru.erase(it->second);
+        s.index.erase(it);
+    }
+
+    // 获取统计信息
+    void stats(uint64_t &size, uint64_t &capacity, uint64_t &hits, uint64_t &misses, uint64_t &evictions)
+    {
+        size = 0;
+        for (auto &s : _shards)
+        {
+            std::unique_lock<std::mutex> lock(s.mutex);
+            size += s.lru.size();
+        }
+        capacity = _shard_capacity * USER_CACHE_SHARDS;
+        hits = _hits.load(std::memory_order_relaxed);
+        misses = _misses.load(std::memory_order_relaxed);
+        evictions = _evictions.load(std::memory_order_relaxed);
+    }
+};
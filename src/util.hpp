@@ -1,4 +1,5 @@
 #pragma once
+#include <string.h>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -11,8 +12,43 @@
 #include <websocketpp/config/asio_no_tls.hpp>
 
 #include "log.hpp"
+#include "str_view.hpp"
 
-typedef websocketpp::server<websocketpp::config::asio> server_t;
+#define MYSQL_CONNECT_TIMEOUT 3 // 连接数据库的超时时间，单位为秒
+
+class session;
+class room;
+
+// websocket连接的类型，在open时根据请求路径确定
+enum connection_kind
+{
+    CONN_HTTP = 0, // 普通http请求，或者还没有通过身份验证的websocket连接
+    CONN_HALL,     // 游戏大厅长连接
+    CONN_ROOM      // 游戏房间长连接
+};
+
+// 每个连接自带的上下文，websocketpp的连接类继承自配置中的connection_base
+// open时验证一次身份并填好上下文，之后每条消息直接读取，不再解析请求头、查找session
+struct connection_context
+{
+    connection_kind kind;
+    std::shared_ptr<session> ssp; // 连接所属的session
+    uint64_t uid;                 // 连接所属的用户id
+    std::shared_ptr<room> rp;     // 房间连接所在的房间
+
+    connection_context()
+        : kind(CONN_HTTP), uid(0)
+    {
+    }
+};
+
+// 在默认的asio配置上换成带上下文的连接基类
+struct server_config : public websocketpp::config::asio
+{
+    typedef connection_context connection_base;
+};
+
+typedef websocketpp::server<server_config> server_t;
 
 // 封装数据库工具类
 class mysql_util
@@ -34,6 +70,10 @@ public:
         }
         DLOG("mysql init success");
 
+        // 数据库不可用时连接池会在借出连接时重连，不能让io线程长时间卡在连接上
+        unsigned int timeout = MYSQL_CONNECT_TIMEOUT;
+        mysql_options(mysql, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+
         // 2.连接数据库
         if (mysql_real_connect(mysql,
                                host.c_str(),
@@ -74,6 +114,33 @@ public:
         return true;
     }
 
+    // 预处理语句的字符串参数或结果，结果的长度写入len
+    static void bind_string(MYSQL_BIND &bind, char *buf, const unsigned long size, unsigned long *len)
+    {
+        memset(&bind, 0, sizeof(bind));
+        bind.buffer_type = MYSQL_TYPE_STRING;
+        bind.buffer = buf;
+        bind.buffer_length = size;
+        bind.length = len;
+    }
+
+    // 预处理语句的64位整数参数或结果
+    static void bind_int64(MYSQL_BIND &bind, void *value, const bool is_unsigned)
+    {
+        memset(&bind, 0, sizeof(bind));
+        bind.buffer_type = MYSQL_TYPE_LONGLONG;
+        bind.buffer = value;
+        bind.is_unsigned = is_unsigned;
+    }
+
+    // 预处理语句的32位整数参数或结果
+    static void bind_int(MYSQL_BIND &bind, int *value)
+    {
+        memset(&bind, 0, sizeof(bind));
+        bind.buffer_type = MYSQL_TYPE_LONG;
+        bind.buffer = value;
+    }
+
     // 关闭连接数据库
     static void mysql_destroy(MYSQL *mysql)
     {
@@ -128,37 +195,7 @@ public:
 
 
 
-// 封装字符串处理功能类
-class string_util
-{
-public:
-    // 进行字符串分割处理
-    static size_t split(const std::string &src, const std::string &sep, std::vector<std::string> &res)
-    {
-        //"123,456,,,789"
-        size_t left = 0, right = 0;
-        while (right < src.size())
-        {
-            right = src.find(sep, right);
-            if (right == std::string::npos)
-            {
-                res.push_back(src.substr(left, right));
-                break;
-            }
-            //",123,456"    //处理特殊情况
-            if (left == right)
-            {
-                right += sep.size();
-                left = right;
-                continue;
-            }
-            res.push_back(src.substr(left, right - left));
-            right += sep.size();
-            left = right;
-        }
-        return res.size();
-    }
-};
+// 字符串处理功能类string_util在str_view.hpp中
 
 
 
@@ -0,0 +1,134 @@
+// 阻塞任务线程池，登录、注册、查询用户信息等需要访问数据库的http请求在这里执行，io线程不等待数据库
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+
+#include "log.hpp"
+
+#define DB_WORKER_THREADS 8      // 线程数，与数据库连接池的连接数相同，更多的线程只会等待连接
+#define DB_WORKER_QUEUE_MAX 4096 // 排队任务数的上限，超过时直接拒绝，避免数据库变慢时请求无限堆积
+
+class db_worker
+{
+private:
+    struct task
+    {
+        std::chrono::steady_clock::time_point enqueued; // 入队时间，用于统计排队延迟
+        std::function<void()> fn;
+    };
+    std::deque<task> _tasks; // 待执行的任务
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::vector<std::thread> _threads;
+    bool _stop;
+
+    uint64_t _peak;        // 排队任务数的峰值
+    uint64_t _completed;   // 执行完的任务数
+    uint64_t _rejected;    // 队列已满被拒绝的任务数
+    uint64_t _wait_us;     // 累计排队时间
+    uint64_t _max_wait_us; // 最长的一次排队时间
+    uint64_t _run_us;      // 累计执行时间
+
+public:
+    db_worker(const int thread_count = DB_WORKER_THREADS)
+        : _stop(false), _peak(0), _completed(0), _rejected(0), _wait_us(0), _max_wait_us(0), _run_us(0)
+    {
+        for (int i = 0; i < thread_count; i++)
+        {
+            _threads.push_back(std::thread(&db_worker::handler_task, this));
+        }
+        DLOG("阻塞任务线程池初始化完毕！！！");
+    }
+
+    // 停止前执行完已经排队的任务
+    ~db_worker()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+            _cond.notify_all();
+        }
+        for (auto &t : _threads)
+        {
+            t.join();
+        }
+        DLOG("阻塞任务线程池销毁完毕！！！");
+    }
+
+    // 投递任务，队列已满时返回false，调用者需要自己响应
+    bool post(const std::function<void()> &fn)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_tasks.size() >= DB_WORKER_QUEUE_MAX)
+        {
+            _rejected++;
+            return false;
+        }
+        _tasks.push_back(task{std::chrono::steady_clock::now(), fn});
+        if (_tasks.size() > _peak)
+        {
+            _peak = _tasks.size();
+        }
+        _cond.notify_one();
+        return true;
+    }
+
+    // 线程池的统计信息，wait_us和run_us为累计的排队和执行时间
+    void stats(uint64_t &pending, uint64_t &peak, uint64_t &completed, uint64_t &rejected, uint64_t &wait_us,
+               uint64_t &max_wait_us, uint64_t &run_us)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        pending = _tasks.size();
+        peak = _peak;
+        completed = _completed;
+        rejected = _rejected;
+        wait_us = _wait_us;
+        max_wait_us = _max_wait_us;
+        run_us = _run_us;
+    }
+
+private:
+    // 线程入口，不断取出任务执行
+    void handler_task()
+    {
+        while (true)
+        {
+            task t;
+            std::chrono::steady_clock::time_point start;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (_tasks.empty() && _stop == false)
+                {
+                    _cond.wait(lock);
+                }
+                if (_tasks.empty())
+                {
+                    return;
+                }
+                t = std::move(_tasks.front());
+                _tasks.pop_front();
+                start = std::chrono::steady_clock::now();
+                uint64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(start - t.enqueued).count();
+                _wait_us += waited;
+                if (waited > _max_wait_us)
+                {
+                    _max_wait_us = waited;
+                }
+            }
+            t.fn();
+            uint64_t ran = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+            std::unique_lock<std::mutex> lock(_mutex);
+            _completed++;
+            _run_us += ran;
+        }
+        return;
+    }
+};